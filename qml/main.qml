@@ -1,7 +1,6 @@
 import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
-import Qt5Compat.GraphicalEffects
 import org.mauikit.controls as Maui
 import QmlGreet 1.0
 
@@ -118,6 +117,32 @@ Window {
     function cancelLoginPrompt() {
         auth.cancel()
         loginStack.currentIndex = 0
+        preselectSelectedUser()
+    }
+
+    // Avatar of a user row, "" for rows that do not exist
+    function avatarUrl(row) {
+        avatarButton.iconRevision // Re-evaluate when the model changes
+        if (row < 0 || row >= userModel.rowCount()) {
+            return ""
+        }
+        var iconPath = userModel.data(userModel.index(row, 0), 259)
+        if (!ConfigShowAvatars || !iconPath) {
+            return "qrc:/icons/user-avatar.svg"
+        }
+        if (iconPath.startsWith("qrc:")) {
+            return iconPath
+        }
+        // The stamp makes RoundImage reload an avatar rewritten in place
+        return "file://" + iconPath + "#" + userModel.data(userModel.index(row, 0), 260)
+    }
+
+    // Lets AuthWrapper create the greetd session ahead of the avatar click
+    function preselectSelectedUser() {
+        var idx = userCombo.currentIndex
+        if (idx >= 0 && loginStack.currentIndex === 0) {
+            auth.preselectUser(userModel.data(userModel.index(idx, 0), 257))
+        }
     }
 
     function movePowerFocus(currentButton, step, allowExit) {
@@ -162,6 +187,13 @@ Window {
         Qt.callLater(function() { focusInitialControl() })
     }
 
+    Connections {
+        target: memoryMonitor
+        function onFirstStableFrame() {
+            memoryMonitor.reclaim()
+        }
+    }
+
     Connections {
         target: sessionModel
         function onRowsInserted() { selectDefaultSession() }
@@ -170,6 +202,9 @@ Window {
 
     AuthWrapper {
         id: auth
+        sessionCommand: sessionCombo.currentIndex >= 0 && sessionCombo.currentValue !== undefined
+            ? sessionCombo.currentValue : ""
+        speculative: ConfigSpeculativeSession
         onPromptChanged: {
             if (auth.currentPrompt !== "") {
                 // Only switch to password view if there's actually a prompt
@@ -177,13 +212,11 @@ Window {
                 loginStack.currentIndex = 1
             }
         }
+        // Only reached when no session was selected when auth succeeded;
+        // otherwise AuthWrapper starts sessionCommand on its own.
         onLoginSucceeded: {
             auth.error = ""
-
-            // Ensure valid selection before launch
-            if (sessionCombo.currentIndex < 0) {
-                selectDefaultSession()
-            }
+            selectDefaultSession()
 
             var idx = sessionCombo.currentIndex
             if (idx >= 0) {
@@ -196,7 +229,7 @@ Window {
         }
         onErrorChanged: {
             if (auth.error !== "") {
-                errorAnimation.start()
+                if (!renderProfile.lowCost) errorAnimation.start()
                 // Show error message for 2 seconds before resetting to avatar view
                 errorResetTimer.start()
             }
@@ -210,6 +243,7 @@ Window {
         repeat: false
         onTriggered: {
             loginStack.currentIndex = 0
+            root.preselectSelectedUser()
         }
     }
 
@@ -217,38 +251,95 @@ Window {
     SystemBattery {
         id: battery
         debugBattery: ConfigDebugBattery
+        paused: outputPower.off
     }
     SessionModel { id: sessionModel }
 
     // --- Background ---
+    // Static between wallpaper changes. On the software renderer it is cached
+    // in a layer, so a clock tick or cursor blink only blits the damaged
+    // region instead of repainting image and overlay underneath it.
+    // Also cached as the splash shown before the next start (SplashSurface)
     Rectangle {
+        objectName: "background"
         anchors.fill: parent
         color: Maui.Theme.backgroundColor
         z: 0
+        layer.enabled: renderProfile.backend === "software"
+        readonly property bool ready: slideshow.active ? slideFront.status === Image.Ready
+            : (backgroundImage.source == "" || backgroundImage.status === Image.Ready)
         Image {
             id: backgroundImage
             anchors.fill: parent
-            source: (ConfigBackgroundImage && ConfigBackgroundImage !== "") ? "file://" + ConfigBackgroundImage : ""
-            fillMode: Image.PreserveAspectCrop
-            visible: false; cache: false
+            // Decoded at output size and blurred once on the CPU; the buffer is
+            // shared with the greeters on other seats
+            source: (!slideshow.active && ConfigBackgroundImage && ConfigBackgroundImage !== "")
+                ? "image://wallpaper/" + (ConfigBlurEnabled ? 64 : 0) + "/" + ConfigBackgroundImage.replace(/^\//, "")
+                : ""
+            sourceSize: Qt.size(root.width, root.height)
+            asynchronous: true
+            cache: false
+        }
+        // Slideshow: images arrive already decoded and blurred, so loading is
+        // synchronous and the front one fades in over the previous one
+        Image {
+            id: slideBack
+            anchors.fill: parent
+            visible: slideshow.active
+            cache: false
+        }
+        Image {
+            id: slideFront
+            anchors.fill: parent
+            visible: slideshow.active
+            cache: false
+        }
+        NumberAnimation {
+            id: slideFade
+            target: slideFront
+            property: "opacity"
+            from: 0; to: 1
+            duration: slideshow.fadeDuration
+            onFinished: slideBack.source = ""
+        }
+        Connections {
+            target: slideshow
+            function onCurrentSourceChanged() {
+                slideFade.stop()
+                slideBack.source = slideFront.source
+                slideFront.opacity = 0
+                slideFront.source = slideshow.currentSource
+                if (renderProfile.lowCost || slideBack.source == "") {
+                    slideFront.opacity = 1
+                    slideBack.source = ""
+                } else {
+                    slideFade.start()
+                }
+            }
+        }
+        Binding {
+            target: slideshow; property: "outputSize"
+            value: Qt.size(root.width * Screen.devicePixelRatio, root.height * Screen.devicePixelRatio)
         }
-        FastBlur {
-            anchors.fill: parent; source: backgroundImage
-            radius: ConfigBlurEnabled ? 64 : 0
-            visible: backgroundImage.status === Image.Ready; cached: true
+        Binding { target: slideshow; property: "blurRadius"; value: ConfigBlurEnabled ? 64 : 0 }
+        // Rotation holds still while an auth prompt is up and when nobody is around
+        Binding {
+            target: slideshow; property: "paused"
+            value: idleMonitor.idle || outputPower.off || auth.processing || loginStack.currentIndex === 1
         }
         Rectangle {
             anchors.fill: parent; opacity: 0.3
-            visible: backgroundImage.status !== Image.Ready
+            visible: !renderProfile.lowCost
+                && (slideshow.active ? slideFront.status !== Image.Ready : backgroundImage.status !== Image.Ready)
             gradient: Gradient {
                 GradientStop { position: 0.0; color: Qt.lighter(Maui.Theme.backgroundColor, 1.1) }
                 GradientStop { position: 1.0; color: Qt.darker(Maui.Theme.backgroundColor, 1.1) }
             }
         }
-    }
-    Rectangle {
-        anchors.fill: parent; color: Maui.Theme.backgroundColor
-        opacity: ConfigOverlayOpacity; visible: ConfigOverlayEnabled; z: 1
+        Rectangle {
+            anchors.fill: parent; color: Maui.Theme.backgroundColor
+            opacity: ConfigOverlayOpacity; visible: ConfigOverlayEnabled
+        }
     }
 
     // --- Top Elements ---
@@ -272,6 +363,24 @@ Window {
             Layout.preferredWidth: 200
             model: userModel
             textRole: "realName"
+            // Follows the user, not the row, when the list changes underneath
+            property string selectedUser: ""
+            onCurrentIndexChanged: {
+                selectedUser = currentIndex >= 0 ? userModel.data(userModel.index(currentIndex, 0), 257) : ""
+                root.preselectSelectedUser()
+            }
+            function reselect() {
+                var idx = userModel.indexOf(selectedUser)
+                if (idx < 0 && userModel.rowCount() > 0) idx = Math.min(Math.max(currentIndex, 0), userModel.rowCount() - 1)
+                if (idx !== currentIndex) currentIndex = idx
+            }
+            Connections {
+                target: userModel
+                function onModelReset() { userCombo.reselect() }
+                function onRowsInserted() { userCombo.reselect() }
+                function onRowsRemoved() { userCombo.reselect() }
+                function onRowsMoved() { userCombo.reselect() }
+            }
             KeyNavigation.tab: sessionCombo
             KeyNavigation.backtab: root.lastVisiblePowerButton(avatarButton)
             Keys.onRightPressed: function(event) {
@@ -302,6 +411,7 @@ Window {
             Layout.preferredWidth: 240
             model: sessionModel
             textRole: "name"
+            valueRole: "exec"
             KeyNavigation.tab: avatarButton
             KeyNavigation.backtab: userCombo
             Keys.onLeftPressed: function(event) {
@@ -335,12 +445,17 @@ Window {
             font.weight: Font.Bold
 
             Timer {
-                interval: 1000; running: true; repeat: true
+                // Nothing to show while the outputs are off; catch up at once on wake
+                interval: 1000; running: !outputPower.off; repeat: true; triggeredOnStart: true
                 onTriggered: {
+                    // Only touch the labels when the text changes, so the
+                    // other 59 ticks a minute produce no damage
                     var d = new Date()
-                    timeLabel.text = Qt.formatDateTime(d, "hh:mm")
+                    var time = Qt.formatDateTime(d, "hh:mm")
+                    if (timeLabel.text !== time) timeLabel.text = time
                     var formattedDate = Qt.formatDateTime(d, "dddd, d MMMM yyyy")
-                    dateLabel.text = ConfigLowercaseDate ? formattedDate.toLowerCase() : formattedDate
+                    if (ConfigLowercaseDate) formattedDate = formattedDate.toLowerCase()
+                    if (dateLabel.text !== formattedDate) dateLabel.text = formattedDate
                 }
             }
         }
@@ -381,7 +496,7 @@ Window {
                 Maui.Icon {
                     Layout.preferredWidth: 16
                     Layout.preferredHeight: 16
-                    source: battery.iconName
+                    source: battery.iconName ? "image://themeicon/" + battery.iconName : ""
                     visible: IconMode !== "nerd"
                 }
 
@@ -441,11 +556,20 @@ Window {
                     activeFocusOnTab: loginStack.currentIndex === 0 && mouseArea.enabled
                     KeyNavigation.tab: root.firstVisiblePowerButton(userCombo)
                     KeyNavigation.backtab: sessionCombo
-                    Behavior on border.color { ColorAnimation { duration: 150 } }
-                    Behavior on color { ColorAnimation { duration: 150 } }
+                    Behavior on border.color { enabled: !renderProfile.lowCost; ColorAnimation { duration: 150 } }
+                    Behavior on color { enabled: !renderProfile.lowCost; ColorAnimation { duration: 150 } }
 
                     property int uIndex: userCombo.currentIndex
-                    property string iconPath: uIndex >= 0 ? userModel.data(userModel.index(uIndex, 0), 259) : ""
+                    // Bumped on model changes, for bindings that read it through data()
+                    property int iconRevision: 0
+
+                    Connections {
+                        target: userModel
+                        function onDataChanged() { avatarButton.iconRevision++ }
+                        function onRowsInserted() { avatarButton.iconRevision++ }
+                        function onRowsRemoved() { avatarButton.iconRevision++ }
+                        function onRowsMoved() { avatarButton.iconRevision++ }
+                    }
 
                     Keys.onPressed: function(event) {
                         switch (event.key) {
@@ -475,47 +599,19 @@ Window {
                     }
 
                     Item {
+                        id: avatarFrame
                         anchors.centerIn: parent
                         width: 138; height: 138
 
-                        Image {
-                            id: avatarImg
-                            anchors.fill: parent
-                            source: {
-                                if (!ConfigShowAvatars) {
-                                    return "qrc:/icons/user-avatar.svg"
-                                }
-
-                                var iconPath = parent.parent.iconPath
-                                console.log("Avatar iconPath:", iconPath)
-                                if (!iconPath) {
-                                    console.log("No iconPath, using fallback")
-                                    return "qrc:/icons/user-avatar.svg"
-                                }
-                                if (iconPath.startsWith("qrc:")) {
-                                    console.log("Using QRC path:", iconPath)
-                                    return iconPath
-                                }
-                                console.log("Using file path:", iconPath)
-                                return "file://" + iconPath
-                            }
-                            fillMode: Image.PreserveAspectCrop
-                            visible: false
-                            cache: false
-                            // Use fallback if image fails to load
-                            onStatusChanged: {
-                                console.log("Avatar status:", status, "source:", source)
-                                if (status === Image.Error) {
-                                    console.log("Image failed to load, trying fallback")
-                                    source = "qrc:/icons/user-avatar.svg"
-                                }
-                            }
-                        }
+                        property string avatarSource: root.avatarUrl(avatarButton.uIndex) || "qrc:/icons/user-avatar.svg"
 
-                        OpacityMask {
-                            anchors.fill: avatarImg
-                            source: avatarImg
-                            maskSource: Rectangle { width: 138; height: 138; radius: 69 }
+                        // Decoded and clipped to a circle off the GUI thread at
+                        // the displayed size; one texture, on every backend
+                        RoundImage {
+                            anchors.fill: parent
+                            source: avatarFrame.avatarSource
+                            // Arrowing through the list then never waits for the disk
+                            prefetch: [root.avatarUrl(avatarButton.uIndex - 1), root.avatarUrl(avatarButton.uIndex + 1)]
                         }
                     }
 
@@ -557,6 +653,7 @@ Window {
 
                 Maui.PasswordField {
                     id: passwordField
+                    objectName: "passwordField"
                     Layout.fillWidth: true
                     Layout.preferredHeight: Maui.Style.rowHeight
                     enabled: !auth.processing
@@ -658,14 +755,14 @@ Window {
                 padding: 0
                 hoverEnabled: true
                 scale: hovered ? 1.12 : 1.0
-                Behavior on scale { NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
+                Behavior on scale { enabled: !renderProfile.lowCost; NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
                 background: Rectangle {
                     radius: Maui.Style.radiusV
                     color: suspendButton.activeFocus ? Qt.alpha(Maui.Theme.highlightColor, 0.18) : suspendButton.hovered ? Qt.alpha(Maui.Theme.textColor, 0.08) : "transparent"
                 }
-                icon.name: "system-suspend"
+                icon.source: "image://themeicon/system-suspend"
                 display: AbstractButton.IconOnly
-                visible: power.canSuspend()
+                visible: power.canSuspend
                 Keys.onLeftPressed: root.movePowerFocus(suspendButton, -1, false)
                 Keys.onRightPressed: root.movePowerFocus(suspendButton, 1, false)
                 Keys.onUpPressed: root.focusLoginSelection()
@@ -681,14 +778,14 @@ Window {
                 padding: 0
                 hoverEnabled: true
                 scale: hovered ? 1.12 : 1.0
-                Behavior on scale { NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
+                Behavior on scale { enabled: !renderProfile.lowCost; NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
                 background: Rectangle {
                     radius: Maui.Style.radiusV
                     color: hibernateButton.activeFocus ? Qt.alpha(Maui.Theme.highlightColor, 0.18) : hibernateButton.hovered ? Qt.alpha(Maui.Theme.textColor, 0.08) : "transparent"
                 }
-                icon.name: "system-suspend-hibernate"
+                icon.source: "image://themeicon/system-suspend-hibernate"
                 display: AbstractButton.IconOnly
-                visible: power.canHibernate()
+                visible: power.canHibernate
                 Keys.onLeftPressed: root.movePowerFocus(hibernateButton, -1, false)
                 Keys.onRightPressed: root.movePowerFocus(hibernateButton, 1, false)
                 Keys.onUpPressed: root.focusLoginSelection()
@@ -704,14 +801,14 @@ Window {
                 padding: 0
                 hoverEnabled: true
                 scale: hovered ? 1.12 : 1.0
-                Behavior on scale { NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
+                Behavior on scale { enabled: !renderProfile.lowCost; NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
                 background: Rectangle {
                     radius: Maui.Style.radiusV
                     color: hybridSleepButton.activeFocus ? Qt.alpha(Maui.Theme.highlightColor, 0.18) : hybridSleepButton.hovered ? Qt.alpha(Maui.Theme.textColor, 0.08) : "transparent"
                 }
-                icon.name: "system-suspend-hibernate"
+                icon.source: "image://themeicon/system-suspend-hibernate"
                 display: AbstractButton.IconOnly
-                visible: power.canHybridSleep()
+                visible: power.canHybridSleep
                 Keys.onLeftPressed: root.movePowerFocus(hybridSleepButton, -1, false)
                 Keys.onRightPressed: root.movePowerFocus(hybridSleepButton, 1, false)
                 Keys.onUpPressed: root.focusLoginSelection()
@@ -727,14 +824,14 @@ Window {
                 padding: 0
                 hoverEnabled: true
                 scale: hovered ? 1.12 : 1.0
-                Behavior on scale { NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
+                Behavior on scale { enabled: !renderProfile.lowCost; NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
                 background: Rectangle {
                     radius: Maui.Style.radiusV
                     color: suspendThenHibernateButton.activeFocus ? Qt.alpha(Maui.Theme.highlightColor, 0.18) : suspendThenHibernateButton.hovered ? Qt.alpha(Maui.Theme.textColor, 0.08) : "transparent"
                 }
-                icon.name: "system-suspend-hibernate"
+                icon.source: "image://themeicon/system-suspend-hibernate"
                 display: AbstractButton.IconOnly
-                visible: power.canSuspendThenHibernate()
+                visible: power.canSuspendThenHibernate
                 Keys.onLeftPressed: root.movePowerFocus(suspendThenHibernateButton, -1, false)
                 Keys.onRightPressed: root.movePowerFocus(suspendThenHibernateButton, 1, false)
                 Keys.onUpPressed: root.focusLoginSelection()
@@ -750,14 +847,14 @@ Window {
                 padding: 0
                 hoverEnabled: true
                 scale: hovered ? 1.12 : 1.0
-                Behavior on scale { NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
+                Behavior on scale { enabled: !renderProfile.lowCost; NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
                 background: Rectangle {
                     radius: Maui.Style.radiusV
                     color: rebootButton.activeFocus ? Qt.alpha(Maui.Theme.highlightColor, 0.18) : rebootButton.hovered ? Qt.alpha(Maui.Theme.textColor, 0.08) : "transparent"
                 }
-                icon.name: "system-reboot"
+                icon.source: "image://themeicon/system-reboot"
                 display: AbstractButton.IconOnly
-                visible: power.canReboot()
+                visible: power.canReboot
                 Keys.onLeftPressed: root.movePowerFocus(rebootButton, -1, false)
                 Keys.onRightPressed: root.movePowerFocus(rebootButton, 1, false)
                 Keys.onUpPressed: root.focusLoginSelection()
@@ -773,14 +870,14 @@ Window {
                 padding: 0
                 hoverEnabled: true
                 scale: hovered ? 1.12 : 1.0
-                Behavior on scale { NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
+                Behavior on scale { enabled: !renderProfile.lowCost; NumberAnimation { duration: 120; easing.type: Easing.OutCubic } }
                 background: Rectangle {
                     radius: Maui.Style.radiusV
                     color: shutdownButton.activeFocus ? Qt.alpha(Maui.Theme.highlightColor, 0.18) : shutdownButton.hovered ? Qt.alpha(Maui.Theme.textColor, 0.08) : "transparent"
                 }
-                icon.name: "system-shutdown"
+                icon.source: "image://themeicon/system-shutdown"
                 display: AbstractButton.IconOnly
-                visible: power.canPowerOff()
+                visible: power.canPowerOff
                 Keys.onLeftPressed: root.movePowerFocus(shutdownButton, -1, false)
                 Keys.onRightPressed: root.movePowerFocus(shutdownButton, 1, false)
                 Keys.onUpPressed: root.focusLoginSelection()
@@ -0,0 +1,125 @@
+#!/usr/bin/env bash
+
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2025-2026 <Nitrux Latinoamericana S.C. <hello@nxos.org>>
+
+# Measures the login flow end to end against tools/fake-greetd:
+# start -> first frame -> user click -> prompt shown -> password submitted
+# -> start_session -> session-started -> process-exit, with qmlgreet rendering
+# offscreen.
+#
+# Usage: scripts/bench-login.sh [RUNS] [BUILD_DIR]
+# Env:   FAKE_GREETD_SCRIPT  prompts/delays JSON for fake-greetd (see tools/fake-greetd/main.cpp)
+#        QMLGREET_BENCH_USER user to log in when there are no regular users (default: $USER)
+#        FAST_EXIT           false to measure the full teardown after start_session (default: true)
+
+
+# -- Exit on errors.
+
+set -e
+
+
+# -- Build qmlgreet and fake-greetd.
+
+RUNS="${1:-5}"
+BUILD_DIR="${2:-.build-bench}"
+
+if [ ! -d "$BUILD_DIR" ]; then
+    meson setup "$BUILD_DIR" --buildtype=release -Dtools=true
+fi
+
+ninja -C "$BUILD_DIR" qmlgreet fake-greetd
+
+
+# -- Run the flow.
+
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+mkdir -p "$WORK_DIR/share/wayland-sessions"
+
+cat > "$WORK_DIR/share/wayland-sessions/bench.desktop" <<EOF
+[Desktop Entry]
+Name=Bench
+Exec=true
+EOF
+
+cat > "$WORK_DIR/qmlgreet.conf" <<EOF
+DefaultSession=Bench
+
+[Behavior]
+SharedAssetCache=
+FastExit=${FAST_EXIT:-true}
+EOF
+
+if [ -n "$FAKE_GREETD_SCRIPT" ]; then
+    GREETD_SCRIPT="$FAKE_GREETD_SCRIPT"
+else
+    GREETD_SCRIPT="$WORK_DIR/script.json"
+    cat > "$GREETD_SCRIPT" <<EOF
+{
+    "create_session_delay_ms": 20,
+    "prompts": [ { "type": "secret", "message": "Password:", "delay_ms": 0, "expect": "bench" } ],
+    "start_session_delay_ms": 10
+}
+EOF
+fi
+
+for run in $(seq 1 "$RUNS"); do
+    SOCKET="$WORK_DIR/greetd-$run.sock"
+
+    "$BUILD_DIR/fake-greetd" --socket "$SOCKET" --script "$GREETD_SCRIPT" \
+        --report "$WORK_DIR/greetd-$run.report" --once 2>/dev/null &
+    GREETD_PID=$!
+
+    # Give fake-greetd 5 seconds to come up
+    tries=0
+    while [ ! -S "$SOCKET" ]; do
+        tries=$((tries + 1))
+        if [ "$tries" -gt 500 ] || ! kill -0 "$GREETD_PID" 2>/dev/null; then
+            echo "fake-greetd did not create $SOCKET" >&2
+            kill "$GREETD_PID" 2>/dev/null
+            exit 1
+        fi
+        sleep 0.01
+    done
+
+    QT_QPA_PLATFORM=offscreen \
+    QT_QUICK_BACKEND="${QT_QUICK_BACKEND:-software}" \
+    XDG_DATA_DIRS="$WORK_DIR/share" \
+    GREETD_SOCK="$SOCKET" \
+    QMLGREET_BENCH=1 \
+    QMLGREET_BENCH_USER="${QMLGREET_BENCH_USER:-$USER}" \
+    QMLGREET_BENCH_PASSWORD=bench \
+    QMLGREET_BENCH_REPORT="$WORK_DIR/greeter-$run.report" \
+        "$BUILD_DIR/qmlgreet" -c "$WORK_DIR/qmlgreet.conf" > /dev/null
+
+    wait "$GREETD_PID"
+
+    # Both reports use CLOCK_MONOTONIC; merge them into one timeline
+    echo "Run $run:"
+    {
+        awk '{ print $3, $2 }' "$WORK_DIR/greeter-$run.report"
+        awk '$1 != "listening" { print $2, "greetd:" $1 }' "$WORK_DIR/greetd-$run.report"
+    } | sort -n | awk -v summary="$WORK_DIR/summary" '
+        NR == 1 { start = $1; previous = $1 }
+        {
+            printf "  %-34s %10.3f ms  (+%.3f)\n", $2, $1 - start, $1 - previous
+            print $2, $1 - start >> summary
+            previous = $1
+        }'
+done
+
+
+# -- Summarize.
+
+echo "Mean over $RUNS run(s):"
+# session-started -> process-exit is the time greetd waits on us after success
+awk '
+    !($1 in count) { order[++stages] = $1 }
+    { total[$1] += $2; count[$1]++ }
+    END {
+        for (i = 1; i <= stages; i++) {
+            printf "  %-34s %10.3f ms\n", order[i], total[order[i]] / count[order[i]]
+        }
+    }' "$WORK_DIR/summary"
@@ -41,11 +41,11 @@ $APT_COMMAND install -y --no-install-recommends \
     ninja-build \
     nlohmann-json3-dev \
     pkg-config \
-    qt6-5compat-dev \
     qt6-base-dev \
     qt6-base-private-dev \
     qt6-declarative-dev \
     qt6-declarative-dev-tools \
+    qt6-declarative-private-dev \
     qt6-l10n-tools \
     qt6-svg-dev \
     qt6-wayland-dev \
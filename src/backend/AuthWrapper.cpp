@@ -1,4 +1,8 @@
 #include "AuthWrapper.h"
+#include "StartupScheduler.h"
+#include "StallWatchdog.h"
+#include "Instrumentation.h"
+#include "FastExit.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -6,9 +10,7 @@
 #include <QDataStream>
 #include <QDebug>
 #include <QSysInfo>
-#include <QTimer>
 #include <QProcess>
-#include <QCoreApplication>
 #include <QSettings>
 #include <QDir>
 #include <QFileInfo>
@@ -21,6 +23,140 @@ AuthWrapper::AuthWrapper(QObject *parent)
     connect(m_socket, &QLocalSocket::errorOccurred, this, &AuthWrapper::onSocketError);
 }
 
+void AuthWrapper::setSessionCommand(const QString &cmd)
+{
+    if (m_sessionCommand == cmd) {
+        return;
+    }
+
+    m_sessionCommand = cmd;
+
+    // Split the command string into executable + args once per selection
+    // e.g. "dbus-run-session sway" becomes ["dbus-run-session", "sway"]
+    m_sessionCmd = QJsonArray();
+    const QStringList args = QProcess::splitCommand(cmd);
+    for (const QString &arg : args) {
+        m_sessionCmd.append(arg);
+    }
+
+    // The environment does not depend on the session; build it once
+    if (m_sessionEnv.isEmpty()) {
+        const QStringList envList = prepareEnv();
+        for (const QString &envVar : envList) {
+            m_sessionEnv.append(envVar);
+        }
+    }
+
+    emit sessionCommandChanged();
+}
+
+void AuthWrapper::setSpeculative(bool speculative)
+{
+    if (m_speculative == speculative) {
+        return;
+    }
+
+    m_speculative = speculative;
+    if (!m_speculative && !m_revealed && !m_speculativeUser.isEmpty()) {
+        abandonSpeculativeSession();
+    }
+    emit speculativeChanged();
+}
+
+void AuthWrapper::preselectUser(const QString &username)
+{
+    // Never interfere with a prompt the user is already answering
+    if (!m_speculative || m_revealed || m_processing || m_sessionStarting) {
+        return;
+    }
+
+    if (username == m_speculativeUser) {
+        return;
+    }
+
+    // Connecting to greetd can block; let the first frame go out before that
+    if (!StartupScheduler::firstFrameShown()) {
+        const bool scheduled = !m_deferredPreselect.isNull();
+        m_deferredPreselect = username;
+        if (!scheduled) {
+            StartupScheduler::schedule(StartupScheduler::PostFirstFrame, QStringLiteral("speculative-session"), this, [this]() {
+                const QString deferred = m_deferredPreselect;
+                m_deferredPreselect = QString();
+                preselectUser(deferred);
+            });
+        }
+        return;
+    }
+
+    if (!m_speculativeUser.isEmpty()) {
+        abandonSpeculativeSession();
+    }
+
+    if (username.isEmpty() || qgetenv("GREETD_SOCK").isEmpty() || !ensureConnected()) {
+        return;
+    }
+
+    m_speculativeUser = username;
+    m_heldReply = QJsonObject();
+
+    QJsonObject request;
+    request["type"] = "create_session";
+    request["username"] = username;
+    qDebug() << "AuthWrapper: Speculatively creating session for user:" << username;
+    m_authTimer.start();
+    sendCommand(request);
+}
+
+void AuthWrapper::abandonSpeculativeSession()
+{
+    qDebug() << "AuthWrapper: Cancelling speculative session for" << m_speculativeUser;
+
+    if (m_socket->state() == QLocalSocket::ConnectedState) {
+        QJsonObject json;
+        json["type"] = "cancel_session";
+        sendCommand(json);
+    }
+
+    // Whatever is still in flight for the old session is stale now
+    ++m_generation;
+    m_speculativeUser.clear();
+    m_heldReply = QJsonObject();
+    m_revealed = false;
+}
+
+bool AuthWrapper::ensureConnected()
+{
+    if (m_socket->state() == QLocalSocket::ConnectedState) {
+        return true;
+    }
+
+    qDebug() << "AuthWrapper: Connecting to greetd socket...";
+    m_pending.clear();
+    m_buffer.clear();
+    m_expectedLength = 0;
+    STALL_SCOPE("AuthWrapper::waitForConnected");
+    LATENCY_SCOPE("greetd.connect");
+    m_socket->connectToServer(QString::fromLocal8Bit(qgetenv("GREETD_SOCK")));
+    if (!m_socket->waitForConnected(1000)) {
+        return false;
+    }
+    qDebug() << "AuthWrapper: Connected to greetd socket";
+    return true;
+}
+
+void AuthWrapper::dropConnection()
+{
+    if (m_socket->state() == QLocalSocket::ConnectedState) {
+        m_socket->disconnectFromServer();
+    }
+    m_pending.clear();
+    m_buffer.clear();
+    m_expectedLength = 0;
+    m_speculativeUser.clear();
+    m_heldReply = QJsonObject();
+    m_revealed = false;
+}
+
 void AuthWrapper::login(const QString &username)
 {
     qDebug() << "AuthWrapper: login() called with username:" << username;
@@ -36,33 +172,50 @@ void AuthWrapper::login(const QString &username)
     m_error = "";
     emit errorChanged();
 
+    if (!m_speculativeUser.isEmpty()) {
+        if (m_speculativeUser == username) {
+            qDebug() << "AuthWrapper: Using speculative session for" << username;
+            m_revealed = true;
+            if (!m_heldReply.isEmpty()) {
+                const QJsonObject reply = m_heldReply;
+                m_heldReply = QJsonObject();
+                handleReply(reply);
+            }
+            // Otherwise the reply is still in flight and goes to the UI on arrival
+            return;
+        }
+        abandonSpeculativeSession();
+    }
+    m_revealed = true;
+
     QString socketPath = qgetenv("GREETD_SOCK");
     qDebug() << "AuthWrapper: GREETD_SOCK =" << socketPath;
 
     if (socketPath.isEmpty()) {
-        qWarning() << "AuthWrapper: No GREETD_SOCK found. Switching to MOCK MODE.";
-        m_isMock = true;
-        runMockLogin(username);
+        // For testing outside greetd, run tools/fake-greetd and point GREETD_SOCK at it
+        qWarning() << "AuthWrapper: GREETD_SOCK is not set";
+        m_error = "Not running under greetd (GREETD_SOCK is not set).";
+        emit errorChanged();
+        m_processing = false;
+        m_revealed = false;
+        emit processingChanged();
         return;
     }
 
-    if (m_socket->state() != QLocalSocket::ConnectedState) {
-        qDebug() << "AuthWrapper: Connecting to greetd socket...";
-        m_socket->connectToServer(socketPath);
-        if (!m_socket->waitForConnected(1000)) {
-            m_error = "Could not connect to greetd socket.";
-            emit errorChanged();
-            m_processing = false;
-            emit processingChanged();
-            return;
-        }
-        qDebug() << "AuthWrapper: Connected to greetd socket";
+    if (!ensureConnected()) {
+        m_error = "Could not connect to greetd socket.";
+        emit errorChanged();
+        m_processing = false;
+        m_revealed = false;
+        emit processingChanged();
+        return;
     }
 
     QJsonObject request;
     request["type"] = "create_session";
     request["username"] = username;
     qDebug() << "AuthWrapper: Sending create_session request for user:" << username;
+    m_authTimer.start();
     sendCommand(request);
 }
 
@@ -85,11 +238,7 @@ void AuthWrapper::respond(const QString &response)
 
     m_processing = true;
     emit processingChanged();
-
-    if (m_isMock) {
-        runMockResponse(response);
-        return;
-    }
+    m_authTimer.start();
 
     QJsonObject json;
     json["type"] = "post_auth_message_response";
@@ -100,27 +249,45 @@ void AuthWrapper::respond(const QString &response)
 
 void AuthWrapper::cancel()
 {
-    if (m_isMock) {
-        reset();
-        return;
-    }
-
     if (m_socket->state() == QLocalSocket::ConnectedState) {
         QJsonObject json;
         json["type"] = "cancel_session";
         sendCommand(json);
+        ++m_generation;
     }
     reset();
 }
 
 void AuthWrapper::startSession(const QString &cmd)
+{
+    setSessionCommand(cmd);
+    sendStartSession();
+}
+
+void AuthWrapper::onAuthenticated()
+{
+    Instrumentation::count("auth.success");
+    if (m_sessionCmd.isEmpty()) {
+        // No session selected yet; let the UI pick one and call startSession()
+        qDebug() << "AuthWrapper: Authentication successful, emitting loginSucceeded signal";
+        m_processing = false;
+        emit processingChanged();
+        emit loginSucceeded();
+        return;
+    }
+
+    qDebug() << "AuthWrapper: Authentication successful, starting selected session";
+    sendStartSession();
+}
+
+void AuthWrapper::sendStartSession()
 {
     m_processing = true;
     m_sessionStarting = true;
     emit processingChanged();
 
     // Safety check for empty commands
-    if (cmd.trimmed().isEmpty()) {
+    if (m_sessionCmd.isEmpty()) {
         qWarning() << "AuthWrapper: startSession called with empty command!";
         m_error = "Internal Error: No session command provided.";
         emit errorChanged();
@@ -130,82 +297,24 @@ void AuthWrapper::startSession(const QString &cmd)
         return;
     }
 
-    qDebug() << "AuthWrapper: Starting session with command:" << cmd;
-
-    if (m_isMock) {
-        qDebug() << "Mock: Requesting launch of:" << cmd;
-        // Simulate a short delay before "launching"
-        QTimer::singleShot(500, this, [this](){
-            qDebug() << "Mock: Session launched! (App would quit now)";
-            QCoreApplication::quit();
-        });
-        return;
-    }
-
-    // Split the command string into executable + args
-    // e.g. "dbus-run-session sway" becomes ["dbus-run-session", "sway"]
-    QStringList args = QProcess::splitCommand(cmd);
-    QJsonArray cmdArray;
-    for (const QString &arg : args) {
-        cmdArray.append(arg);
-    }
-
-    qDebug() << "AuthWrapper: Command split into" << args.size() << "arguments:" << args;
-
-    // Prepare environment variables
-    QStringList envList = prepareEnv();
-    QJsonArray envArray;
-    for (const QString &envVar : envList) {
-        envArray.append(envVar);
-    }
-
-    qDebug() << "AuthWrapper: Prepared" << envList.size() << "environment variables";
+    qDebug() << "AuthWrapper: Starting session with command:" << m_sessionCommand;
 
     // Protocol: { "type": "start_session", "cmd": ["prog", "arg1", ...], "env": ["VAR=value", ...] }
     QJsonObject json;
     json["type"] = "start_session";
-    json["cmd"] = cmdArray;
+    json["cmd"] = m_sessionCmd;
 
-    if (!envArray.isEmpty()) {
-        json["env"] = envArray;
+    if (!m_sessionEnv.isEmpty()) {
+        json["env"] = m_sessionEnv;
     }
 
     sendCommand(json);
-}
-
-void AuthWrapper::runMockLogin(const QString &username)
-{
-    // Simulate network delay of 500ms
-    QTimer::singleShot(500, this, [this, username]() {
-        qDebug() << "Mock: Asking for password for" << username;
-        m_prompt = "Mock Password (type 'fail' to error):";
-        m_isSecret = true;
-        m_processing = false;
-        
-        emit promptChanged();
-        emit processingChanged();
-    });
-}
+    emit sessionStartSent();
 
-void AuthWrapper::runMockResponse(const QString &response)
-{
-    // Simulate processing delay
-    QTimer::singleShot(600, this, [this, response]() {
-        if (response == "fail") {
-             qDebug() << "Mock: Authentication failed";
-             m_error = "Mock Error: Invalid credentials (you typed 'fail')";
-             emit errorChanged();
-             
-             // Reset UI to allow retry
-             m_processing = false;
-             emit processingChanged();
-        } else {
-             qDebug() << "Mock: Authentication successful";
-             m_processing = false;
-             emit processingChanged();
-             emit loginSucceeded();
-        }
-    });
+    if (m_authTimer.isValid()) {
+        qInfo() << "AuthWrapper: start_session sent" << m_authTimer.elapsed()
+                << "ms after the last auth request";
+    }
 }
 
 void AuthWrapper::sendCommand(const QJsonObject &json)
@@ -222,6 +331,10 @@ void AuthWrapper::sendCommand(const QJsonObject &json)
     packet.append(data);
     m_socket->write(packet);
     m_socket->flush();
+
+    // greetd answers every request exactly once, in order
+    m_pending.enqueue({json["type"].toString(), m_generation,
+                       Instrumentation::enabled() ? Instrumentation::nowNs() : 0});
 }
 
 void AuthWrapper::onReadyRead()
@@ -257,37 +370,76 @@ void AuthWrapper::processMessage(const QJsonObject &json)
 {
     qDebug() << "AuthWrapper: Received message from greetd:" << QJsonDocument(json).toJson(QJsonDocument::Compact);
 
-    QString type = json["type"].toString();
+    PendingRequest request;
+    request.generation = m_generation;
+    if (!m_pending.isEmpty()) {
+        request = m_pending.dequeue();
+        Instrumentation::record("greetd." + request.type.toLatin1(), request.sentAt);
+    }
 
-    if (type == "success") {
-        if (m_canceling) {
-            // Successfully canceled the session after an error
-            qDebug() << "AuthWrapper: Session canceled successfully, resetting for retry";
-            m_canceling = false;
-            m_processing = false;
-            m_prompt = "";
+    if (request.type == "cancel_session") {
+        handleCancelReply();
+        return;
+    }
 
-            // Close and reset the socket to allow fresh login attempts
-            if (m_socket->state() == QLocalSocket::ConnectedState) {
-                m_socket->disconnectFromServer();
-            }
+    if (request.generation != m_generation) {
+        qDebug() << "AuthWrapper: Ignoring" << request.type << "reply for a cancelled session";
+        return;
+    }
 
-            emit processingChanged();
-            emit promptChanged();
-            // Don't emit loginSucceeded - the error was already set
+    // Speculative session the user has not asked for yet
+    if (!m_speculativeUser.isEmpty() && !m_revealed) {
+        if (json["type"].toString() == "error") {
+            qWarning() << "AuthWrapper: Speculative session for" << m_speculativeUser << "failed:"
+                       << json["description"].toString();
+            abandonSpeculativeSession();
             return;
         }
+        qDebug() << "AuthWrapper: Holding reply until" << m_speculativeUser << "is chosen";
+        m_heldReply = json;
+        return;
+    }
+
+    handleReply(json);
+}
+
+void AuthWrapper::handleCancelReply()
+{
+    if (!m_canceling) {
+        // Speculative or user-initiated cancel; nothing left to do
+        return;
+    }
+
+    // Successfully canceled the session after an error
+    qDebug() << "AuthWrapper: Session canceled successfully, resetting for retry";
+    m_canceling = false;
+    m_processing = false;
+    m_prompt = "";
+
+    // Close and reset the socket to allow fresh login attempts, unless a
+    // new (speculative) session was already started on it
+    if (m_pending.isEmpty()) {
+        dropConnection();
+    }
+
+    emit processingChanged();
+    emit promptChanged();
+    // Don't emit loginSucceeded - the error was already set
+}
+
+void AuthWrapper::handleReply(const QJsonObject &json)
+{
+    QString type = json["type"].toString();
 
+    if (type == "success") {
         if (m_sessionStarting) {
             qDebug() << "AuthWrapper: Session started successfully, quitting greeter";
-            // Session started successfully - greetd will now launch the session
-            // The greeter should exit
-            QCoreApplication::quit();
+            // Session started successfully - greetd launches the session once
+            // the greeter has exited, so leave without tearing everything down
+            emit sessionStarted();
+            FastExit::quit();
         } else {
-            qDebug() << "AuthWrapper: Authentication successful, emitting loginSucceeded signal";
-            m_processing = false;
-            emit processingChanged();
-            emit loginSucceeded();
+            onAuthenticated();
         }
     }
     else if (type == "auth_message") {
@@ -324,9 +476,12 @@ void AuthWrapper::processMessage(const QJsonObject &json)
         }
 
         qWarning() << "greetd error:" << errorType << "-" << description;
+        Instrumentation::count(errorType == "auth_error" ? "auth.failure" : "auth.error");
 
         m_processing = false;
         m_sessionStarting = false;
+        m_revealed = false;
+        m_speculativeUser.clear();
         emit errorChanged();
         emit processingChanged();
 
@@ -336,6 +491,7 @@ void AuthWrapper::processMessage(const QJsonObject &json)
             QJsonObject cancelJson;
             cancelJson["type"] = "cancel_session";
             sendCommand(cancelJson);
+            ++m_generation;
         } else {
             // Socket already closed, just reset to allow retry
             m_canceling = false;
@@ -347,12 +503,11 @@ void AuthWrapper::processMessage(const QJsonObject &json)
 
 void AuthWrapper::onSocketError(QLocalSocket::LocalSocketError)
 {
-    if (m_isMock) return; // Ignore socket errors in mock mode
-
     m_error = "Socket Error: " + m_socket->errorString();
     emit errorChanged();
     m_processing = false;
     emit processingChanged();
+    dropConnection();
     reset();
 }
 
@@ -364,9 +519,9 @@ void AuthWrapper::reset()
     m_processing = false;
     m_sessionStarting = false;
     m_canceling = false;
-    m_expectedLength = 0;
-    m_buffer.clear();
-    m_isMock = false;
+    m_revealed = false;
+    m_speculativeUser.clear();
+    m_heldReply = QJsonObject();
 
     emit promptChanged();
     emit processingChanged();
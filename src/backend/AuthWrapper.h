@@ -3,7 +3,10 @@
 #include <QObject>
 #include <QLocalSocket>
 #include <QJsonObject>
+#include <QJsonArray>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QQueue>
 #include <QStringList>
 
 /**
@@ -19,6 +22,10 @@ class AuthWrapper : public QObject
     Q_PROPERTY(bool isSecret READ isSecret NOTIFY promptChanged)
     Q_PROPERTY(QString error READ error WRITE setError NOTIFY errorChanged)
     Q_PROPERTY(bool processing READ processing NOTIFY processingChanged)
+    // The Exec line of the selected session, launched as soon as auth succeeds
+    Q_PROPERTY(QString sessionCommand READ sessionCommand WRITE setSessionCommand NOTIFY sessionCommandChanged)
+    // Create the greetd session as soon as a user is selected (opt-in)
+    Q_PROPERTY(bool speculative READ speculative WRITE setSpeculative NOTIFY speculativeChanged)
 
 public:
     explicit AuthWrapper(QObject *parent = nullptr);
@@ -28,6 +35,8 @@ public:
     bool isSecret() const { return m_isSecret; }
     QString error() const { return m_error; }
     bool processing() const { return m_processing; }
+    QString sessionCommand() const { return m_sessionCommand; }
+    bool speculative() const { return m_speculative; }
 
     // Property Setters
     void setError(const QString &error) {
@@ -37,6 +46,23 @@ public:
         }
     }
 
+    /**
+     * @brief Selects the session to launch and pre-splits it for start_session.
+     * @param cmd The command string (e.g. "dbus-run-session sway")
+     */
+    void setSessionCommand(const QString &cmd);
+
+    void setSpeculative(bool speculative);
+
+    /**
+     * @brief Speculatively creates the greetd session for the selected user.
+     * The first prompt is held back until login() is called for the same user,
+     * so it can be shown instantly. Selecting another user cancels the
+     * speculative session and creates a new one. No-op unless speculative is set.
+     * @param username The user currently selected in the UI.
+     */
+    Q_INVOKABLE void preselectUser(const QString &username);
+
     /**
      * @brief Initiates the login process for a specific user.
      * @param username The user to log in (e.g., "root", "jdoe").
@@ -56,7 +82,8 @@ public:
 
     /**
      * @brief Launches the actual desktop environment.
-     * Call this ONLY after loginSucceeded() is emitted.
+     * Only needed when no sessionCommand was set before auth succeeded;
+     * otherwise start_session is sent directly on success.
      * @param cmd The command string (e.g. "/usr/bin/startplasma-wayland")
      */
     Q_INVOKABLE void startSession(const QString &cmd);
@@ -65,27 +92,45 @@ signals:
     void promptChanged();
     void errorChanged();
     void processingChanged();
+    void sessionCommandChanged();
+    void speculativeChanged();
     
-    // Emitted when authentication is 100% complete.
+    // Emitted when authentication is 100% complete but no sessionCommand is set.
     // The UI should listen for this and then call startSession().
     void loginSucceeded();
 
+    // Emitted once start_session was written to greetd
+    void sessionStartSent();
+
+    // Emitted when greetd confirmed start_session, right before the greeter exits
+    void sessionStarted();
+
 private slots:
     void onReadyRead();
     void onSocketError(QLocalSocket::LocalSocketError socketError);
 
 private:
+    // A request sent to greetd, matched in order against its reply
+    struct PendingRequest {
+        QString type;
+        quint64 generation = 0;
+        qint64 sentAt = 0;  // Instrumentation::nowNs() when latency recording is on
+    };
+
     // Helpers
+    bool ensureConnected();
+    void dropConnection();
     void sendCommand(const QJsonObject &json);
     void processMessage(const QJsonObject &json);
+    void handleReply(const QJsonObject &json);
+    void handleCancelReply();
+    void abandonSpeculativeSession();
     void reset();
+    void onAuthenticated();
+    void sendStartSession();
     
     QStringList prepareEnv();
 
-    // Mock Helpers
-    void runMockLogin(const QString &username);
-    void runMockResponse(const QString &response);
-
     QLocalSocket *m_socket;
 
     // Internal State
@@ -93,10 +138,29 @@ private:
     QString m_error;
     bool m_isSecret = false;
     bool m_processing = false;
-    bool m_isMock = false;
     bool m_sessionStarting = false;
     bool m_canceling = false;
 
+    // Selected session, pre-split into start_session arguments
+    QString m_sessionCommand;
+    QJsonArray m_sessionCmd;
+    QJsonArray m_sessionEnv;
+
+    // Started when the last auth request (login or password) is sent
+    QElapsedTimer m_authTimer;
+
+    // Requests awaiting a reply. Replies to requests from an older generation
+    // belong to a cancelled session and are dropped.
+    QQueue<PendingRequest> m_pending;
+    quint64 m_generation = 0;
+
+    // Speculative session state
+    bool m_speculative = false;
+    bool m_revealed = false;      // The user asked to log in; replies go to the UI
+    QString m_speculativeUser;
+    QJsonObject m_heldReply;      // First reply, held until revealed
+    QString m_deferredPreselect;  // Latest preselection requested before the first frame
+
     // Buffer for incoming JSON packets
     QByteArray m_buffer;
     quint32 m_expectedLength = 0;
@@ -0,0 +1,155 @@
+#include "AvatarImageProvider.h"
+#include "Instrumentation.h"
+#include "SharedAssetCache.h"
+#include "ThreadPriority.h"
+#include <QDebug>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QRegularExpression>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace {
+
+const QSize kDefaultSize(138, 138);
+
+} // namespace
+
+AvatarImageProvider::AvatarImageProvider(SharedAssetCache *sharedCache, qint64 cacheBytes)
+    : QQuickImageProvider(QQuickImageProvider::Image)
+    , m_sharedCache(sharedCache)
+    , m_cache(cacheBytes)
+{
+    // Prefetching is speculative; it must not compete with visible decodes
+    m_prefetchPool.setMaxThreadCount(1);
+}
+
+QString AvatarImageProvider::cacheKey(const QString &id, const QSize &size)
+{
+    return QStringLiteral("%1@%2x%3").arg(id).arg(size.width()).arg(size.height());
+}
+
+QImage AvatarImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    const QSize targetSize = requestedSize.isValid() ? requestedSize : kDefaultSize;
+    const QString key = cacheKey(id, targetSize);
+
+    QImage image;
+    {
+        QMutexLocker locker(&m_mutex);
+        // The prefetch already reads this file; take its result
+        while (m_prefetching.contains(key)) {
+            m_prefetchDone.wait(&m_mutex);
+        }
+        if (const QImage *cached = m_cache.object(key)) {
+            image = *cached;
+        }
+    }
+
+    // Decoded without the lock, so other avatars are not held up behind it
+    if (image.isNull()) {
+        image = decode(id, targetSize);
+        QMutexLocker locker(&m_mutex);
+        m_cache.insert(key, new QImage(image), image.sizeInBytes());
+    }
+
+    if (size) {
+        *size = image.size();
+    }
+    return image;
+}
+
+QImage AvatarImageProvider::decode(const QString &id, const QSize &size) const
+{
+    static const QRegularExpression revision(QStringLiteral("#\\d+$"));
+    QString path = id;
+    path.remove(revision);
+    if (path.startsWith(QStringLiteral("qrc:"))) {
+        path = path.mid(3); // "qrc:/icons/x" -> ":/icons/x"
+    }
+
+    QImage image;
+    if (m_sharedCache) {
+        const QByteArray params = QByteArray::number(size.width()) + 'x' + QByteArray::number(size.height());
+        image = m_sharedCache->findOrCreate(SharedAssetCache::keyFor(QStringLiteral("avatar"), path, params), [&]() {
+            return clipToCircle(path, size);
+        });
+    } else {
+        image = clipToCircle(path, size);
+    }
+    if (image.isNull()) {
+        qWarning() << "AvatarImageProvider: Could not decode" << path << ", using fallback";
+        image = clipToCircle(QStringLiteral(":/icons/user-avatar.svg"), size);
+    }
+    return image;
+}
+
+void AvatarImageProvider::prefetch(const QString &id, const QSize &size)
+{
+    if (id.isEmpty() || size.isEmpty()) {
+        return;
+    }
+
+    const QString key = cacheKey(id, size);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_cache.contains(key) || m_prefetching.contains(key)) {
+            return;
+        }
+        m_prefetching.insert(key);
+    }
+
+    (void)QtConcurrent::run(&m_prefetchPool, [this, id, size, key]() {
+        ThreadPriority::enter(ThreadPriority::Background);
+        const QImage image = decode(id, size);
+        QMutexLocker locker(&m_mutex);
+        m_cache.insert(key, new QImage(image), image.sizeInBytes());
+        m_prefetching.remove(key);
+        m_prefetchDone.wakeAll();
+    });
+}
+
+qint64 AvatarImageProvider::cacheBytes()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.totalCost();
+}
+
+QImage AvatarImageProvider::clipToCircle(const QString &path, const QSize &size)
+{
+    LATENCY_SCOPE("image.decode");
+    QImageReader reader(path);
+    reader.setDecideFormatFromContent(true);
+
+    // Decode directly at a size that covers the target (PreserveAspectCrop)
+    const QSize sourceSize = reader.size();
+    if (sourceSize.isValid()) {
+        reader.setScaledSize(sourceSize.scaled(size, Qt::KeepAspectRatioByExpanding));
+    } else {
+        reader.setScaledSize(size);
+    }
+
+    const QImage source = reader.read();
+    if (source.isNull()) {
+        return QImage();
+    }
+
+    // Center crop to the target size
+    const QImage cropped = source.copy((source.width() - size.width()) / 2,
+                                       (source.height() - size.height()) / 2,
+                                       size.width(), size.height());
+
+    QImage result(size, QImage::Format_ARGB32_Premultiplied);
+    result.fill(Qt::transparent);
+
+    // Painting the ellipse with an image brush gives an antialiased edge,
+    // which a clip path would not.
+    QPainter painter(&result);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QBrush(cropped));
+    painter.drawEllipse(QRectF(QPointF(0, 0), QSizeF(size)));
+    painter.end();
+
+    return result;
+}
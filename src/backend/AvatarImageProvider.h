@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QQuickImageProvider>
+#include <QSet>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+class SharedAssetCache;
+
+/**
+ * @brief Serves avatars already clipped to a circle on the CPU.
+ * Used by RoundImage, or request as "image://avatar/<path>" with a sourceSize set.
+ * Clipped avatars are shared with other seats through the SharedAssetCache.
+ *
+ * Decoded avatars are kept in a bounded LRU keyed by id and size, so going
+ * back to a user never touches the disk. An id may end in "#<revision>"
+ * (e.g. the file's mtime) to tell apart contents rewritten under one path.
+ */
+class AvatarImageProvider : public QQuickImageProvider
+{
+public:
+    explicit AvatarImageProvider(SharedAssetCache *sharedCache = nullptr, qint64 cacheBytes = 8 * 1024 * 1024);
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+
+    /**
+     * @brief Decodes an avatar into the cache on a worker thread, so a later
+     * requestImage() for the same id and size is a memory lookup.
+     */
+    void prefetch(const QString &id, const QSize &size);
+
+    // Bytes held by the decoded avatar cache
+    qint64 cacheBytes();
+
+private:
+    static QString cacheKey(const QString &id, const QSize &size);
+    // Decodes (or maps from the shared cache) without touching m_cache
+    QImage decode(const QString &id, const QSize &size) const;
+    static QImage clipToCircle(const QString &path, const QSize &size);
+
+    SharedAssetCache *m_sharedCache;
+    QMutex m_mutex;
+    QCache<QString, QImage> m_cache;   // Cost in bytes
+    QSet<QString> m_prefetching;
+    QWaitCondition m_prefetchDone;     // A visible request waits instead of decoding twice
+    // Declared last: destroyed first, waiting for prefetches that use the cache
+    QThreadPool m_prefetchPool;
+};
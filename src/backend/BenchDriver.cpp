@@ -0,0 +1,184 @@
+#include "BenchDriver.h"
+#include "AuthWrapper.h"
+#include "Instrumentation.h"
+#include "StartupScheduler.h"
+#include <QAbstractItemModel>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QQmlApplicationEngine>
+#include <QQmlContext>
+#include <QQuickWindow>
+#include <QTextStream>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+namespace {
+constexpr int kTimeoutMs = 30000;
+
+// Read by the exit handler, after the driver itself is gone
+qint64 s_exitProcessStartNs = 0;
+std::string s_exitReportPath;
+
+void markProcessExit()
+{
+    const qint64 now = Instrumentation::nowNs();
+    char line[128];
+    snprintf(line, sizeof(line), "bench process-exit %.3f %.3f\n",
+             double(now) / 1e6, double(now - s_exitProcessStartNs) / 1e6);
+
+    fputs(line, stdout);
+    fflush(stdout);
+    if (!s_exitReportPath.empty()) {
+        if (FILE *report = fopen(s_exitReportPath.c_str(), "a")) {
+            fputs(line, report);
+            fclose(report);
+        }
+    }
+}
+}
+
+BenchDriver::BenchDriver(qint64 processStartNs, QQmlApplicationEngine *engine, QQuickWindow *window,
+                         StartupScheduler *scheduler, QObject *parent)
+    : QObject(parent)
+    , m_engine(engine)
+    , m_window(window)
+    , m_processStartNs(processStartNs)
+{
+    const QString reportPath = qEnvironmentVariable("QMLGREET_BENCH_REPORT");
+    if (!reportPath.isEmpty()) {
+        m_report.setFileName(reportPath);
+        if (!m_report.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            qWarning() << "BenchDriver: Cannot write" << reportPath;
+        }
+    }
+
+    markAt("start", m_processStartNs);
+    mark("engine-loaded");
+
+    // Also covers the teardown after main() returns, or the fast exit path
+    s_exitProcessStartNs = m_processStartNs;
+    s_exitReportPath = reportPath.toStdString();
+    std::atexit(markProcessExit);
+    std::at_quick_exit(markProcessExit);
+
+    if (m_window) {
+        m_auth = m_window->findChild<AuthWrapper *>();
+    }
+    if (!m_auth) {
+        fail(QStringLiteral("no AuthWrapper in the scene"), 2);
+        return;
+    }
+
+    connect(m_auth, &AuthWrapper::promptChanged, this, &BenchDriver::onPromptChanged);
+    connect(m_auth, &AuthWrapper::sessionStartSent, this, [this]() { mark("start-session-sent"); });
+    connect(m_auth, &AuthWrapper::sessionStarted, this, [this]() { mark("session-started"); });
+    connect(m_auth, &AuthWrapper::errorChanged, this, [this]() {
+        if (!m_auth->error().isEmpty()) {
+            fail(m_auth->error(), 3);
+        }
+    });
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() { mark("quit"); });
+
+    connect(scheduler, &StartupScheduler::firstFrameSwapped, this, [this]() {
+        mark("first-frame");
+        QTimer::singleShot(0, this, &BenchDriver::clickAvatar);
+    });
+
+    m_timeout.setSingleShot(true);
+    connect(&m_timeout, &QTimer::timeout, this, [this]() {
+        fail(QStringLiteral("login flow did not finish within %1 ms").arg(kTimeoutMs), 2);
+    });
+    m_timeout.start(kTimeoutMs);
+}
+
+bool BenchDriver::isRequested()
+{
+    return qEnvironmentVariableIntValue("QMLGREET_BENCH") > 0;
+}
+
+void BenchDriver::finish()
+{
+    mark("exit");
+}
+
+void BenchDriver::mark(const char *stage)
+{
+    markAt(stage, Instrumentation::nowNs());
+}
+
+void BenchDriver::markAt(const char *stage, qint64 now)
+{
+    const QString line = QStringLiteral("bench %1 %2 %3")
+        .arg(QLatin1String(stage))
+        .arg(double(now) / 1e6, 0, 'f', 3)
+        .arg(double(now - m_processStartNs) / 1e6, 0, 'f', 3);
+
+    // stdout is not captured by the syslog message handler
+    fprintf(stdout, "%s\n", qPrintable(line));
+    fflush(stdout);
+    if (m_report.isOpen()) {
+        QTextStream(&m_report) << line << '\n';
+        m_report.flush();
+    }
+}
+
+void BenchDriver::clickAvatar()
+{
+    mark("user-click");
+
+    const auto *users = qobject_cast<QAbstractItemModel *>(
+        m_engine->rootContext()->contextProperty(QStringLiteral("userModel")).value<QObject *>());
+    if (users && users->rowCount() > 0) {
+        QMetaObject::invokeMethod(m_window, "startSelectedUserLogin");
+        return;
+    }
+
+    // No regular users on this machine (e.g. CI); log in a named user directly
+    const QString user = qEnvironmentVariable("QMLGREET_BENCH_USER");
+    if (user.isEmpty()) {
+        fail(QStringLiteral("no users to select; set QMLGREET_BENCH_USER"), 2);
+        return;
+    }
+    m_auth->login(user);
+}
+
+void BenchDriver::onPromptChanged()
+{
+    if (m_promptAnswered || m_auth->currentPrompt().isEmpty() || !m_window) {
+        return;
+    }
+    m_promptAnswered = true;
+
+    // The prompt counts as shown once a frame containing it was presented
+    auto connection = std::make_shared<QMetaObject::Connection>();
+    *connection = connect(m_window, &QQuickWindow::frameSwapped, this, [this, connection]() {
+        disconnect(*connection);
+        mark("prompt-shown");
+        submitPassword();
+    }, Qt::QueuedConnection);
+    m_window->update();
+}
+
+void BenchDriver::submitPassword()
+{
+    QObject *field = m_window->findChild<QObject *>(QStringLiteral("passwordField"));
+    if (!field) {
+        fail(QStringLiteral("no passwordField in the scene"), 2);
+        return;
+    }
+
+    field->setProperty("text", qEnvironmentVariable("QMLGREET_BENCH_PASSWORD", QStringLiteral("bench")));
+    mark("password-submitted");
+    QMetaObject::invokeMethod(field, "accepted");
+}
+
+void BenchDriver::fail(const QString &reason, int exitCode)
+{
+    mark("failed");
+    fprintf(stderr, "qmlgreet bench: %s\n", qPrintable(reason));
+    fflush(stderr);
+    ::_exit(exitCode);
+}
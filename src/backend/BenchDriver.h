@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QFile>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class AuthWrapper;
+class QQmlApplicationEngine;
+class QQuickWindow;
+class StartupScheduler;
+
+/**
+ * @brief Drives main.qml through a complete login for benchmarking.
+ *
+ * Enabled by QMLGREET_BENCH=1 (normally via scripts/bench-login.sh against
+ * tools/fake-greetd). After the first frame it clicks the avatar, answers the
+ * prompt with $QMLGREET_BENCH_PASSWORD and prints "bench <stage> <ms>" lines
+ * (the last one, process-exit, from an exit handler)
+ * with CLOCK_MONOTONIC timestamps, so they can be merged with the fake
+ * greetd's report.
+ */
+class BenchDriver : public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchDriver(qint64 processStartNs, QQmlApplicationEngine *engine, QQuickWindow *window,
+                StartupScheduler *scheduler, QObject *parent = nullptr);
+
+    static bool isRequested();
+
+    // Records the last stage right before the process exits
+    void finish();
+
+private:
+    void mark(const char *stage);
+    void markAt(const char *stage, qint64 ns);
+    void clickAvatar();
+    void onPromptChanged();
+    void submitPassword();
+    void fail(const QString &reason, int exitCode);
+
+    QQmlApplicationEngine *m_engine;
+    QPointer<QQuickWindow> m_window;
+    QPointer<AuthWrapper> m_auth;
+    QFile m_report;
+    QTimer m_timeout;
+    const qint64 m_processStartNs;
+    bool m_promptAnswered = false;
+};
@@ -0,0 +1,100 @@
+#include "DamageStats.h"
+#include <QDebug>
+#include <QQuickWindow>
+#include <QSGRendererInterface>
+
+// The software renderer keeps the region it repainted for the backing store
+// flush; it is not exposed through public API
+#include <QtQuick/private/qquickwindow_p.h>
+#include <QtQuick/private/qsgsoftwarerenderer_p.h>
+
+namespace {
+
+quint64 regionPixels(const QRegion &region)
+{
+    quint64 pixels = 0;
+    for (const QRect &rect : region) {
+        pixels += quint64(rect.width()) * quint64(rect.height());
+    }
+    return pixels;
+}
+
+QString percent(quint64 part, quint64 whole)
+{
+    return whole ? QString::number(100.0 * double(part) / double(whole), 'f', 1) + QLatin1Char('%')
+                 : QStringLiteral("-");
+}
+
+} // namespace
+
+DamageStats::DamageStats(QObject *parent)
+    : QObject(parent)
+{
+    m_logTimer.setInterval(10000);
+    connect(&m_logTimer, &QTimer::timeout, this, &DamageStats::logInterval);
+}
+
+void DamageStats::attachWindow(QQuickWindow *window)
+{
+    if (!window) {
+        return;
+    }
+
+    m_window = window;
+    m_software = QQuickWindow::graphicsApi() == QSGRendererInterface::Software;
+    if (!m_software) {
+        qInfo() << "DamageStats: Scene graph backend repaints whole frames;"
+                << "partial updates need QT_QUICK_BACKEND=software";
+    }
+
+    connect(window, &QQuickWindow::afterRendering, this, &DamageStats::recordFrame, Qt::DirectConnection);
+    m_logTimer.start();
+}
+
+void DamageStats::recordFrame()
+{
+    const qreal ratio = m_window->effectiveDevicePixelRatio();
+    const quint64 total = quint64(qRound(m_window->width() * ratio)) * quint64(qRound(m_window->height() * ratio));
+    quint64 damaged = total;
+
+    if (m_software) {
+        // Runs right after the renderer painted, before the region is flushed
+        auto *renderer = static_cast<QSGSoftwareRenderer *>(QQuickWindowPrivate::get(m_window)->renderer);
+        if (renderer) {
+            damaged = qMin(total, regionPixels(renderer->flushRegion()));
+        }
+    }
+
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    m_damagedPixels.fetch_add(damaged, std::memory_order_relaxed);
+    m_totalPixels.fetch_add(total, std::memory_order_relaxed);
+}
+
+void DamageStats::logInterval()
+{
+    const quint64 frames = m_frames.load(std::memory_order_relaxed);
+    const quint64 damaged = m_damagedPixels.load(std::memory_order_relaxed);
+    const quint64 total = m_totalPixels.load(std::memory_order_relaxed);
+    if (frames == m_loggedFrames) {
+        return;
+    }
+
+    const quint64 frameCount = frames - m_loggedFrames;
+    qInfo().noquote() << "DamageStats:" << frameCount << "frame(s)," << (damaged - m_loggedDamaged) / frameCount
+                      << "of" << (total - m_loggedTotal) / frameCount << "px damaged per frame"
+                      << '(' + percent(damaged - m_loggedDamaged, total - m_loggedTotal) + ')';
+
+    m_loggedFrames = frames;
+    m_loggedDamaged = damaged;
+    m_loggedTotal = total;
+}
+
+void DamageStats::logSummary() const
+{
+    const quint64 frames = m_frames.load(std::memory_order_relaxed);
+    const quint64 damaged = m_damagedPixels.load(std::memory_order_relaxed);
+    const quint64 total = m_totalPixels.load(std::memory_order_relaxed);
+
+    qInfo().noquote() << "DamageStats:" << frames << "frame(s)," << damaged << "of" << total
+                      << "px damaged (" + percent(damaged, total) + ')';
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <atomic>
+
+class QQuickWindow;
+
+/**
+ * @brief Counts damaged versus total pixels per rendered frame.
+ *
+ * With the software scene graph only the dirty region is repainted and
+ * handed to the compositor as buffer damage; with an RHI backend every frame
+ * is a full repaint. Totals are logged every 10 seconds while frames are
+ * being rendered, and once more at exit.
+ */
+class DamageStats : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DamageStats(QObject *parent = nullptr);
+
+    void attachWindow(QQuickWindow *window);
+
+    // Logs the totals since startup
+    void logSummary() const;
+
+private:
+    void recordFrame();
+    void logInterval();
+
+    QQuickWindow *m_window = nullptr;
+    bool m_software = false;
+    QTimer m_logTimer;
+
+    // Written on the render thread, read on the GUI thread
+    std::atomic<quint64> m_frames{0};
+    std::atomic<quint64> m_damagedPixels{0};
+    std::atomic<quint64> m_totalPixels{0};
+
+    quint64 m_loggedFrames = 0;
+    quint64 m_loggedDamaged = 0;
+    quint64 m_loggedTotal = 0;
+};
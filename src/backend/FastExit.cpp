@@ -0,0 +1,87 @@
+#include "FastExit.h"
+#include "ThreadPriority.h"
+#include <QDebug>
+#include <QGuiApplication>
+#include <QThreadPool>
+#include <QWindow>
+#include <cstdio>
+#include <cstdlib>
+#include <syslog.h>
+#include <wayland-client.h>
+
+#include <qpa/qplatformnativeinterface.h>
+
+namespace {
+
+// A splash, readahead or metrics write that misses this is lost, and its
+// QSaveFile temporary is left behind
+constexpr int kMaintenanceWaitMs = 300;
+
+} // namespace
+
+bool FastExit::s_enabled = false;
+QPointer<QWindow> FastExit::s_window;
+std::vector<std::function<void()>> FastExit::s_hooks;
+
+void FastExit::setEnabled(bool enabled)
+{
+    s_enabled = enabled;
+}
+
+void FastExit::setWindow(QWindow *window)
+{
+    s_window = window;
+}
+
+void FastExit::addHook(std::function<void()> hook)
+{
+    s_hooks.push_back(std::move(hook));
+}
+
+void FastExit::runHooks()
+{
+    // Hooks run once, whichever exit path gets here first
+    std::vector<std::function<void()>> hooks;
+    hooks.swap(s_hooks);
+    for (const auto &hook : hooks) {
+        hook();
+    }
+}
+
+void FastExit::quit(int exitCode)
+{
+    if (!s_enabled) {
+        QCoreApplication::quit();
+        return;
+    }
+
+    qInfo() << "FastExit: Session confirmed, exiting without teardown";
+
+    // Unmap first so the compositor stops showing the greeter right away.
+    // hide() waits for the render thread to let go of the surface.
+    if (s_window) {
+        s_window->hide();
+    }
+    if (QPlatformNativeInterface *native = QGuiApplication::platformNativeInterface()) {
+        auto *display = static_cast<struct wl_display *>(native->nativeResourceForIntegration("wl_display"));
+        if (display) {
+            wl_display_flush(display);
+        }
+    }
+
+    runHooks();
+
+    // Let writes in flight (and those the hooks queued) commit; the session
+    // only waits for this on logins that race a cache rewrite
+    if (!ThreadPriority::pool(ThreadPriority::Maintenance)->waitForDone(kMaintenanceWaitMs)) {
+        qWarning() << "FastExit: Maintenance tasks still running after" << kMaintenanceWaitMs << "ms, exiting anyway";
+    }
+
+    // The log file is flushed per message; syslog and stdio are what is left
+    closelog();
+    fflush(stdout);
+    fflush(stderr);
+
+    // Skips static destructors and atexit handlers; at_quick_exit handlers run
+    std::quick_exit(exitCode);
+}
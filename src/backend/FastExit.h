@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QPointer>
+#include <functional>
+#include <vector>
+
+class QWindow;
+
+/**
+ * @brief Leaves the greeter as soon as greetd confirmed start_session.
+ *
+ * greetd starts the user's session once the greeter process is gone, so a
+ * full teardown (QML engine, scene graph, models, layer surface) only delays
+ * the login. quit() unmaps the window, runs the registered exit hooks (log
+ * summaries, benchmark marks), gives the maintenance pool's cache writes a
+ * short, bounded time to commit, flushes logs and calls std::quick_exit().
+ * When disabled, quit() is QCoreApplication::quit().
+ */
+class FastExit
+{
+public:
+    static void setEnabled(bool enabled);
+    static void setWindow(QWindow *window);
+
+    // Runs before the process exits, on either path
+    static void addHook(std::function<void()> hook);
+    static void runHooks();
+
+    static void quit(int exitCode = 0);
+
+private:
+    static bool s_enabled;
+    static QPointer<QWindow> s_window;
+    static std::vector<std::function<void()>> s_hooks;
+};
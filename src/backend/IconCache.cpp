@@ -0,0 +1,304 @@
+#include "IconCache.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QIcon>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSettings>
+#include <QTextStream>
+#include <climits>
+
+static const char *const kIconExtensions[] = { ".png", ".svg", ".svgz", ".xpm" };
+
+IconCache::IconCache(const QString &cacheFile)
+    : m_cacheFile(cacheFile)
+{
+}
+
+QString IconCache::lookup(const QString &name, int size)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureTheme();
+
+    const QString key = QStringLiteral("%1@%2").arg(name).arg(size);
+    auto it = m_entries.constFind(key);
+    if (it != m_entries.constEnd()) {
+        return *it;
+    }
+
+    const QString path = resolve(name, size);
+    m_entries.insert(key, path);
+    m_dirty = true;
+    return path;
+}
+
+void IconCache::warm(const QStringList &names, int size)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        ensureTheme();
+
+        for (const QString &name : names) {
+            const QString key = QStringLiteral("%1@%2").arg(name).arg(size);
+            if (!m_entries.contains(key)) {
+                m_entries.insert(key, resolve(name, size));
+                m_dirty = true;
+            }
+        }
+    }
+    save();
+}
+
+void IconCache::ensureTheme()
+{
+    if (m_themeReady) {
+        return;
+    }
+    m_themeReady = true;
+
+    m_theme = QIcon::themeName();
+    if (m_theme.isEmpty()) {
+        m_theme = QStringLiteral("hicolor");
+    }
+
+    m_searchPaths = QIcon::themeSearchPaths();
+    const QString localIcons = QDir::homePath() + QStringLiteral("/.local/share/icons");
+    if (!m_searchPaths.contains(localIcons)) {
+        m_searchPaths.prepend(localIcons);
+    }
+
+    m_chain = themeChain(m_theme);
+
+    // The stamp only needs the theme roots and their index files, not a
+    // walk of the icon directories
+    qint64 newest = 0;
+    for (const QString &theme : std::as_const(m_chain)) {
+        for (const QString &base : themeBaseDirs(theme)) {
+            newest = qMax(newest, QFileInfo(base).lastModified().toSecsSinceEpoch());
+            newest = qMax(newest, QFileInfo(base + QStringLiteral("/index.theme")).lastModified().toSecsSinceEpoch());
+        }
+    }
+    m_themeStamp = QStringLiteral("%1:%2").arg(m_chain.join(QLatin1Char(','))).arg(newest);
+
+    load();
+}
+
+void IconCache::load()
+{
+    QFile file(m_cacheFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return;
+    }
+
+    QTextStream in(&file);
+    const QStringList header = in.readLine().split(QLatin1Char('\t'));
+    if (header.size() != 2 || header[0] != m_theme || header[1] != m_themeStamp) {
+        qInfo() << "IconCache: Icon theme changed, discarding" << m_cacheFile;
+        m_dirty = true;
+        return;
+    }
+
+    while (!in.atEnd()) {
+        const QStringList fields = in.readLine().split(QLatin1Char('\t'));
+        if (fields.size() == 2) {
+            m_entries.insert(fields[0], fields[1]);
+        }
+    }
+    qDebug() << "IconCache: Loaded" << m_entries.size() << "entries for theme" << m_theme;
+}
+
+void IconCache::save()
+{
+    // Written from a copy, so lookups on the provider threads do not wait for the disk
+    QMutexLocker locker(&m_mutex);
+    if (!m_dirty || m_cacheFile.isEmpty()) {
+        return;
+    }
+    const QString theme = m_theme;
+    const QString themeStamp = m_themeStamp;
+    const QHash<QString, QString> entries = m_entries;
+    m_dirty = false;
+    locker.unlock();
+
+    QDir().mkpath(QFileInfo(m_cacheFile).absolutePath());
+    QSaveFile file(m_cacheFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "IconCache: Cannot write" << m_cacheFile;
+        return;
+    }
+
+    QTextStream out(&file);
+    out << theme << '\t' << themeStamp << '\n';
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        out << it.key() << '\t' << it.value() << '\n';
+    }
+    out.flush();
+    if (!file.commit()) {
+        qWarning() << "IconCache: Cannot write" << m_cacheFile;
+    }
+}
+
+QString IconCache::resolve(const QString &name, int size) const
+{
+    // "battery-good-charging" -> "battery-good" -> "battery"
+    QString candidate = name;
+    while (!candidate.isEmpty()) {
+        for (const QString &theme : m_chain) {
+            const QString path = resolveInTheme(theme, candidate, size);
+            if (!path.isEmpty()) {
+                return path;
+            }
+        }
+
+        const int dash = candidate.lastIndexOf(QLatin1Char('-'));
+        candidate = dash > 0 ? candidate.left(dash) : QString();
+    }
+
+    for (const char *ext : kIconExtensions) {
+        const QString path = QStringLiteral("/usr/share/pixmaps/") + name + QLatin1String(ext);
+        if (QFileInfo::exists(path)) {
+            return path;
+        }
+    }
+
+    return QString();
+}
+
+QString IconCache::resolveInTheme(const QString &theme, const QString &name, int size) const
+{
+    const QStringList bases = themeBaseDirs(theme);
+    const QList<ThemeDir> dirs = themeDirectories(theme);
+
+    QString closest;
+    int closestDistance = INT_MAX;
+
+    for (const ThemeDir &dir : dirs) {
+        const bool exact = directoryMatchesSize(dir, size);
+        const int distance = exact ? 0 : directorySizeDistance(dir, size);
+        if (!exact && distance >= closestDistance) {
+            continue;
+        }
+
+        for (const QString &base : bases) {
+            for (const char *ext : kIconExtensions) {
+                const QString path = base + QLatin1Char('/') + dir.path + QLatin1Char('/') + name + QLatin1String(ext);
+                if (!QFileInfo::exists(path)) {
+                    continue;
+                }
+                if (exact) {
+                    return path;
+                }
+                closest = path;
+                closestDistance = distance;
+            }
+        }
+    }
+
+    return closest;
+}
+
+QList<IconCache::ThemeDir> IconCache::themeDirectories(const QString &theme) const
+{
+    QList<ThemeDir> dirs;
+
+    for (const QString &base : themeBaseDirs(theme)) {
+        const QString indexPath = base + QStringLiteral("/index.theme");
+        if (!QFileInfo::exists(indexPath)) {
+            continue;
+        }
+
+        QSettings index(indexPath, QSettings::IniFormat);
+        const QStringList names = index.value(QStringLiteral("Icon Theme/Directories")).toStringList();
+        for (const QString &name : names) {
+            ThemeDir dir;
+            dir.path = name;
+            index.beginGroup(name);
+            dir.size = index.value(QStringLiteral("Size")).toInt();
+            dir.minSize = index.value(QStringLiteral("MinSize"), dir.size).toInt();
+            dir.maxSize = index.value(QStringLiteral("MaxSize"), dir.size).toInt();
+            dir.threshold = index.value(QStringLiteral("Threshold"), 2).toInt();
+            dir.scale = index.value(QStringLiteral("Scale"), 1).toInt();
+            dir.type = index.value(QStringLiteral("Type"), QStringLiteral("Threshold")).toString();
+            index.endGroup();
+
+            // HiDPI variants are never requested by the greeter
+            if (dir.size > 0 && dir.scale == 1) {
+                dirs << dir;
+            }
+        }
+        break;
+    }
+
+    return dirs;
+}
+
+QStringList IconCache::themeChain(const QString &theme) const
+{
+    QStringList chain;
+    QStringList queue { theme };
+
+    while (!queue.isEmpty()) {
+        const QString current = queue.takeFirst();
+        if (current.isEmpty() || chain.contains(current)) {
+            continue;
+        }
+        chain << current;
+
+        for (const QString &base : themeBaseDirs(current)) {
+            const QString indexPath = base + QStringLiteral("/index.theme");
+            if (QFileInfo::exists(indexPath)) {
+                QSettings index(indexPath, QSettings::IniFormat);
+                queue << index.value(QStringLiteral("Icon Theme/Inherits")).toStringList();
+                break;
+            }
+        }
+    }
+
+    if (!chain.contains(QStringLiteral("hicolor"))) {
+        chain << QStringLiteral("hicolor");
+    }
+    return chain;
+}
+
+QStringList IconCache::themeBaseDirs(const QString &theme) const
+{
+    QStringList bases;
+    for (const QString &searchPath : m_searchPaths) {
+        const QString base = searchPath + QLatin1Char('/') + theme;
+        if (QFileInfo(base).isDir()) {
+            bases << base;
+        }
+    }
+    return bases;
+}
+
+bool IconCache::directoryMatchesSize(const ThemeDir &dir, int size)
+{
+    if (dir.type == QStringLiteral("Fixed")) {
+        return dir.size == size;
+    }
+    if (dir.type == QStringLiteral("Scalable")) {
+        return dir.minSize <= size && size <= dir.maxSize;
+    }
+    return dir.size - dir.threshold <= size && size <= dir.size + dir.threshold;
+}
+
+int IconCache::directorySizeDistance(const ThemeDir &dir, int size)
+{
+    if (dir.type == QStringLiteral("Fixed")) {
+        return qAbs(dir.size - size);
+    }
+    if (dir.type == QStringLiteral("Scalable")) {
+        if (size < dir.minSize) {
+            return dir.minSize - size;
+        }
+        return size > dir.maxSize ? size - dir.maxSize : 0;
+    }
+    if (size < dir.size - dir.threshold) {
+        return dir.minSize - size;
+    }
+    return size > dir.size + dir.threshold ? size - dir.maxSize : 0;
+}
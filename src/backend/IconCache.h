@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Persistent icon-name -> file-path lookup cache.
+ * Entries are keyed by icon theme, theme modification stamp, name and size,
+ * so the icon theme directories are only walked when the theme changes.
+ * Thread-safe; lookups may come from image provider threads.
+ */
+class IconCache
+{
+public:
+    explicit IconCache(const QString &cacheFile);
+
+    /**
+     * @brief Returns the file best matching the icon name at the given size,
+     * or an empty string if the theme chain has no such icon.
+     */
+    QString lookup(const QString &name, int size);
+
+    /**
+     * @brief Resolves a set of names ahead of time and persists the result.
+     */
+    void warm(const QStringList &names, int size);
+
+    /**
+     * @brief Writes the cache file if lookups added entries since the last
+     * save. Lookups themselves never write.
+     */
+    void save();
+
+private:
+    struct ThemeDir {
+        QString path;
+        int size = 0;
+        int minSize = 0;
+        int maxSize = 0;
+        int threshold = 2;
+        int scale = 1;
+        QString type;
+    };
+
+    void ensureTheme();
+    void load();
+    QString resolve(const QString &name, int size) const;
+    QString resolveInTheme(const QString &theme, const QString &name, int size) const;
+    QList<ThemeDir> themeDirectories(const QString &theme) const;
+    QStringList themeChain(const QString &theme) const;
+    QStringList themeBaseDirs(const QString &theme) const;
+    static bool directoryMatchesSize(const ThemeDir &dir, int size);
+    static int directorySizeDistance(const ThemeDir &dir, int size);
+
+    QMutex m_mutex;
+    QString m_cacheFile;
+    QString m_theme;
+    QString m_themeStamp;
+    QStringList m_chain;
+    QStringList m_searchPaths;
+    QHash<QString, QString> m_entries; // "name@size" -> path ("" = not found)
+    bool m_themeReady = false;
+    bool m_dirty = false;
+};
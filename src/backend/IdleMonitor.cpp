@@ -0,0 +1,87 @@
+#include "IdleMonitor.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEvent>
+
+IdleMonitor::IdleMonitor(int timeoutMs, QObject *parent)
+    : QObject(parent)
+    , m_timeoutMs(timeoutMs)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, [this]() { setIdle(true); });
+
+    if (m_timeoutMs > 0) {
+        m_timer.start(m_timeoutMs);
+    }
+    QCoreApplication::instance()->installEventFilter(this);
+}
+
+void IdleMonitor::setConsumeInput(bool consume)
+{
+    m_consumeInput = consume;
+}
+
+bool IdleMonitor::eventFilter(QObject *watched, QEvent *event)
+{
+    // Decided before activity() is emitted, which may clear m_consumeInput
+    const bool consume = m_consumeInput || m_absorbing;
+
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::TouchBegin:
+    case QEvent::TabletPress:
+        if (consume) {
+            m_absorbing = true;
+        }
+        Q_FALLTHROUGH();
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+        // Events are delivered to several receivers; the timer restart is cheap
+        if (m_timeoutMs > 0) {
+            m_timer.start(m_timeoutMs);
+        }
+        setIdle(false);
+        emit activity();
+        return consume;
+    case QEvent::KeyRelease:
+    case QEvent::MouseButtonRelease:
+    case QEvent::TouchEnd:
+    case QEvent::TouchCancel:
+    case QEvent::TabletRelease:
+        if (consume) {
+            m_absorbing = false;
+            return true;
+        }
+        break;
+    case QEvent::TouchUpdate:
+    case QEvent::TabletMove:
+        if (consume) {
+            return true;
+        }
+        break;
+    case QEvent::ShortcutOverride:
+        // Accepted, so the shortcut map does not act on the key either
+        if (consume) {
+            event->accept();
+            return true;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+void IdleMonitor::setIdle(bool idle)
+{
+    if (m_idle == idle) {
+        return;
+    }
+
+    m_idle = idle;
+    qDebug() << "IdleMonitor:" << (m_idle ? "Idle" : "Active again");
+    emit idleChanged();
+}
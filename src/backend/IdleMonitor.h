@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+
+/**
+ * @brief Tracks user input across the application and reports when nobody
+ * has touched the greeter for a while.
+ */
+class IdleMonitor : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool idle READ idle NOTIFY idleChanged)
+
+public:
+    // timeoutMs <= 0 never reports idle
+    explicit IdleMonitor(int timeoutMs, QObject *parent = nullptr);
+
+    bool idle() const { return m_idle; }
+    int timeoutMs() const { return m_timeoutMs; }
+
+    /**
+     * @brief While set, input only counts as activity and never reaches the
+     * UI; a consumed press also takes its release with it. Used while the
+     * outputs are off, so the waking click or key cannot act on a screen
+     * nobody sees.
+     */
+    void setConsumeInput(bool consume);
+
+signals:
+    void idleChanged();
+    // Any key, pointer or touch input
+    void activity();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void setIdle(bool idle);
+
+    const int m_timeoutMs;
+    QTimer m_timer;
+    bool m_idle = false;
+    bool m_consumeInput = false;
+    bool m_absorbing = false;  // A consumed press whose release is still to come
+};
@@ -0,0 +1,214 @@
+#include "Instrumentation.h"
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QObject>
+#include <QSocketNotifier>
+#include <chrono>
+#include <map>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace Instrumentation {
+
+std::atomic<bool> g_enabled { false };
+
+namespace {
+
+QMutex &registryMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+std::map<QByteArray, Histogram *> &registry()
+{
+    static std::map<QByteArray, Histogram *> histograms;
+    return histograms;
+}
+
+std::map<QByteArray, std::atomic<quint64> *> &counters()
+{
+    static std::map<QByteArray, std::atomic<quint64> *> counters;
+    return counters;
+}
+
+int s_signalFds[2] = { -1, -1 };
+
+void handleDumpSignal(int)
+{
+    const char byte = 1;
+    // Nothing to do if the pipe is full; a dump is already pending
+    (void)::write(s_signalFds[0], &byte, sizeof(byte));
+}
+
+} // namespace
+
+// log2 microsecond buckets
+double Histogram::bucketUpperMs(int index)
+{
+    return index == 0 ? 0.001 : double(quint64(1) << index) / 1000.0;
+}
+
+double Histogram::percentileMs(double p) const
+{
+    const quint64 total = count();
+    if (total == 0) {
+        return 0.0;
+    }
+
+    const quint64 target = quint64(p * double(total - 1)) + 1;
+    quint64 seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += bucket(i);
+        if (seen >= target) {
+            return bucketUpperMs(i);
+        }
+    }
+    return bucketUpperMs(kBuckets - 1);
+}
+
+void Histogram::record(qint64 ns)
+{
+    const quint64 us = quint64(qMax<qint64>(0, ns)) / 1000;
+    int bucket = 0;
+    while (bucket < kBuckets - 1 && (quint64(1) << bucket) <= us) {
+        ++bucket;
+    }
+
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_totalNs.fetch_add(quint64(qMax<qint64>(0, ns)), std::memory_order_relaxed);
+
+    qint64 max = m_maxNs.load(std::memory_order_relaxed);
+    while (ns > max && !m_maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::dump() const
+{
+    const quint64 count = m_count.load(std::memory_order_relaxed);
+    if (count == 0) {
+        return;
+    }
+
+    const double meanMs = double(m_totalNs.load(std::memory_order_relaxed)) / double(count) / 1e6;
+    const double maxMs = double(m_maxNs.load(std::memory_order_relaxed)) / 1e6;
+    qInfo().nospace().noquote() << "Latency: " << m_name << " n=" << count
+                                << " mean=" << QString::number(meanMs, 'f', 3) << "ms"
+                                << " p50<=" << percentileMs(0.50) << "ms"
+                                << " p90<=" << percentileMs(0.90) << "ms"
+                                << " p99<=" << percentileMs(0.99) << "ms"
+                                << " max=" << QString::number(maxMs, 'f', 3) << "ms";
+}
+
+void setEnabled(bool enabled)
+{
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Histogram &histogram(const QByteArray &name)
+{
+    QMutexLocker locker(&registryMutex());
+    Histogram *&entry = registry()[name];
+    if (!entry) {
+        entry = new Histogram(name);
+    }
+    return *entry;
+}
+
+void record(const QByteArray &name, qint64 startNs)
+{
+    if (enabled() && startNs > 0) {
+        histogram(name).record(nowNs() - startNs);
+    }
+}
+
+Histogram &Site::get()
+{
+    Histogram *hist = resolved.load(std::memory_order_acquire);
+    if (!hist) {
+        hist = &histogram(QByteArray(name));
+        resolved.store(hist, std::memory_order_release);
+    }
+    return *hist;
+}
+
+void dump()
+{
+    if (!enabled()) {
+        return;
+    }
+
+    QMutexLocker locker(&registryMutex());
+    qInfo() << "Latency: Histograms for" << registry().size() << "operation(s)";
+    for (const auto &entry : registry()) {
+        entry.second->dump();
+    }
+}
+
+void forEachHistogram(const std::function<void(const Histogram &)> &visit)
+{
+    QMutexLocker locker(&registryMutex());
+    for (const auto &entry : registry()) {
+        visit(*entry.second);
+    }
+}
+
+void count(const QByteArray &name)
+{
+    std::atomic<quint64> *counter;
+    {
+        QMutexLocker locker(&registryMutex());
+        std::atomic<quint64> *&entry = counters()[name];
+        if (!entry) {
+            entry = new std::atomic<quint64>(0);
+        }
+        counter = entry;
+    }
+    counter->fetch_add(1, std::memory_order_relaxed);
+}
+
+void forEachCounter(const std::function<void(const QByteArray &, quint64)> &visit)
+{
+    QMutexLocker locker(&registryMutex());
+    for (const auto &entry : counters()) {
+        visit(entry.first, entry.second->load(std::memory_order_relaxed));
+    }
+}
+
+void installSignalDump(QObject *parent)
+{
+    if (s_signalFds[0] >= 0) {
+        return;
+    }
+
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, s_signalFds) != 0) {
+        qWarning() << "Latency: Cannot create the SIGUSR1 socket pair";
+        return;
+    }
+
+    // Only the byte is passed through the signal handler; the dump runs in the event loop
+    auto *notifier = new QSocketNotifier(s_signalFds[1], QSocketNotifier::Read, parent);
+    QObject::connect(notifier, &QSocketNotifier::activated, notifier, []() {
+        char buffer[16];
+        while (::read(s_signalFds[1], buffer, sizeof(buffer)) > 0) {
+        }
+        dump();
+    });
+
+    struct sigaction action = {};
+    action.sa_handler = handleDumpSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+}
+
+} // namespace Instrumentation
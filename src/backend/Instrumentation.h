@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QByteArray>
+#include <atomic>
+#include <functional>
+
+class QObject;
+
+// Per-operation latency histograms for external I/O (D-Bus, greetd, sysfs,
+// NSS, image probes). Recording is a relaxed atomic load when disabled.
+//
+//     LATENCY_SCOPE("logind.PowerOff");
+//
+// times the rest of the enclosing block. Histograms are dumped to the log on
+// exit and on SIGUSR1, and exported by MetricsExporter.
+namespace Instrumentation {
+
+class Histogram
+{
+public:
+    // log2 buckets over microseconds: [0,1us), [1,2us), ... the last is open-ended
+    static constexpr int kBuckets = 26;
+
+    explicit Histogram(const QByteArray &name) : m_name(name) {}
+
+    void record(qint64 ns);
+    void dump() const;
+
+    const QByteArray &name() const { return m_name; }
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    quint64 totalNs() const { return m_totalNs.load(std::memory_order_relaxed); }
+    quint64 bucket(int index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+    // Upper bound of a bucket, in ms
+    static double bucketUpperMs(int index);
+    // Reported as the upper bound of the bucket the percentile falls in
+    double percentileMs(double p) const;
+
+private:
+    QByteArray m_name;
+    std::atomic<quint64> m_buckets[kBuckets] = {};
+    std::atomic<quint64> m_count { 0 };
+    std::atomic<quint64> m_totalNs { 0 };
+    std::atomic<qint64> m_maxNs { 0 };
+};
+
+extern std::atomic<bool> g_enabled;
+
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+void setEnabled(bool enabled);
+
+qint64 nowNs();
+
+// Returns the histogram for a name, creating it on first use. Never freed.
+Histogram &histogram(const QByteArray &name);
+
+// Records a measurement taken by hand, e.g. across an async call.
+void record(const QByteArray &name, qint64 startNs);
+
+// Logs every histogram with samples
+void dump();
+
+// Visits every histogram, in name order
+void forEachHistogram(const std::function<void(const Histogram &)> &visit);
+
+// Event counters, e.g. failed logins. Counted even when latency recording is off.
+void count(const QByteArray &name);
+void forEachCounter(const std::function<void(const QByteArray &, quint64)> &visit);
+
+// Dumps the histograms whenever SIGUSR1 arrives
+void installSignalDump(QObject *parent);
+
+// Call-site state for LATENCY_SCOPE; constant-initialised so an unused or
+// disabled site costs no static guard or registry lookup.
+struct Site
+{
+    constexpr explicit Site(const char *siteName) : name(siteName) {}
+    Histogram &get();
+
+    const char *name;
+    std::atomic<Histogram *> resolved { nullptr };
+};
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Site &site)
+        : m_site(enabled() ? &site : nullptr)
+        , m_startNs(m_site ? nowNs() : 0)
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        if (m_site) {
+            m_site->get().record(nowNs() - m_startNs);
+        }
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    Site *m_site;
+    qint64 m_startNs;
+};
+
+} // namespace Instrumentation
+
+#define LATENCY_SCOPE_CONCAT_(a, b) a##b
+#define LATENCY_SCOPE_IMPL_(name, line) \
+    static Instrumentation::Site LATENCY_SCOPE_CONCAT_(latencySite_, line)(name); \
+    Instrumentation::ScopedTimer LATENCY_SCOPE_CONCAT_(latencyTimer_, line)(LATENCY_SCOPE_CONCAT_(latencySite_, line))
+#define LATENCY_SCOPE(name) LATENCY_SCOPE_IMPL_(name, __LINE__)
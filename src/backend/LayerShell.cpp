@@ -1,7 +1,9 @@
 #include "LayerShell.h"
+#include "StallWatchdog.h"
 #include <QDebug>
 #include <QGuiApplication>
 #include <QWindow>
+#include <QtMath>
 
 // Include the actual header for QPlatformNativeInterface
 // This is a private Qt header but necessary for Wayland native access
@@ -26,6 +28,8 @@ LayerShell::~LayerShell()
 {
     if (m_layerSurface) zwlr_layer_surface_v1_destroy(m_layerSurface);
     if (m_layerShell) zwlr_layer_shell_v1_destroy(m_layerShell);
+    if (m_fractionalScaleManager) wp_fractional_scale_manager_v1_destroy(m_fractionalScaleManager);
+    if (m_viewporter) wp_viewporter_destroy(m_viewporter);
     // Do NOT destroy m_wlDisplay or m_wlRegistry; Qt owns those.
 }
 
@@ -69,7 +73,10 @@ void LayerShell::initWayland()
     wl_registry_add_listener(m_wlRegistry, &registry_listener, this);
     
     // Roundtrip to ensure we get the globals
-    wl_display_roundtrip(m_wlDisplay);
+    {
+        STALL_SCOPE("LayerShell::roundtrip(globals)");
+        wl_display_roundtrip(m_wlDisplay);
+    }
 
     if (m_layerShell) {
         createLayerSurface();
@@ -84,6 +91,10 @@ void LayerShell::registryHandleGlobal(void *data, struct wl_registry *registry,
     LayerShell *self = static_cast<LayerShell*>(data);
     if (strcmp(interface, zwlr_layer_shell_v1_interface.name) == 0) {
         self->m_layerShell = (struct zwlr_layer_shell_v1 *)wl_registry_bind(registry, name, &zwlr_layer_shell_v1_interface, 1);
+    } else if (strcmp(interface, wp_fractional_scale_manager_v1_interface.name) == 0) {
+        self->m_fractionalScaleManager = (struct wp_fractional_scale_manager_v1 *)wl_registry_bind(registry, name, &wp_fractional_scale_manager_v1_interface, 1);
+    } else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
+        self->m_viewporter = (struct wp_viewporter *)wl_registry_bind(registry, name, &wp_viewporter_interface, 1);
     }
 }
 
@@ -135,6 +146,7 @@ void LayerShell::createLayerSurface()
     
     // Initial commit to apply changes
     wl_surface_commit(m_wlSurface);
+    STALL_SCOPE("LayerShell::roundtrip(configure)");
     wl_display_roundtrip(m_wlDisplay);
 }
 
@@ -153,11 +165,36 @@ void LayerShell::layerSurfaceHandleConfigure(void *data, struct zwlr_layer_surfa
     
     if (!self->m_configured) {
         self->m_configured = true;
+        self->checkBufferScale();
         // Sometimes a second commit is needed to force the render
         // wl_surface_commit(self->m_wlSurface); 
     }
 }
 
+void LayerShell::checkBufferScale()
+{
+    // Qt's Wayland plugin attaches wp_fractional_scale_v1 and wp_viewport to
+    // the surface we promoted and renders at the preferred buffer size
+    // (surface size * scale / 120). A second fractional scale object on the
+    // same surface is a protocol error, so all we do here is make sure that
+    // path is in effect; otherwise the compositor rescales our buffers.
+    const bool fractional = m_fractionalScaleManager && m_viewporter;
+    const qreal ratio = m_window->devicePixelRatio();
+    const QSize bufferSize(qRound(m_window->width() * ratio), qRound(m_window->height() * ratio));
+
+    qInfo() << "LayerShell: Surface" << m_window->size() << "buffer" << bufferSize << "scale" << ratio
+            << (fractional ? "(fractional scaling available)" : "(integer scaling only)");
+
+    const QByteArray disabled = qgetenv("QT_WAYLAND_DISABLED_INTERFACES");
+    if (fractional && (disabled.contains(wp_fractional_scale_manager_v1_interface.name)
+                       || disabled.contains(wp_viewporter_interface.name))) {
+        qWarning() << "LayerShell: QT_WAYLAND_DISABLED_INTERFACES disables fractional scaling;"
+                   << "the compositor will rescale every frame";
+    } else if (!fractional && !qFuzzyCompare(ratio, qCeil(ratio))) {
+        qWarning() << "LayerShell: Fractional scale" << ratio << "without compositor support";
+    }
+}
+
 void LayerShell::layerSurfaceHandleClosed(void *data, struct zwlr_layer_surface_v1 *surface)
 {
     (void)data;    // Unused parameter
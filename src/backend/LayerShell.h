@@ -4,6 +4,8 @@
 #include <QWindow>
 #include <wayland-client.h>
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
+#include "fractional-scale-v1-client-protocol.h"
+#include "viewporter-client-protocol.h"
 
 class LayerShell : public QObject
 {
@@ -34,6 +36,7 @@ public:
 private:
     void initWayland();
     void createLayerSurface();
+    void checkBufferScale();
 
     // Member Variables
     QWindow *m_window = nullptr;
@@ -42,6 +45,10 @@ private:
     struct zwlr_layer_shell_v1 *m_layerShell = nullptr;
     struct zwlr_layer_surface_v1 *m_layerSurface = nullptr;
     struct wl_surface *m_wlSurface = nullptr;
+    // Only bound to find out whether the compositor offers fractional scaling;
+    // Qt attaches the per-surface objects itself
+    struct wp_fractional_scale_manager_v1 *m_fractionalScaleManager = nullptr;
+    struct wp_viewporter *m_viewporter = nullptr;
     
     bool m_configured = false;
 };
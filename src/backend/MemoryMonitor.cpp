@@ -0,0 +1,198 @@
+#include "MemoryMonitor.h"
+#include <QDebug>
+#include <QFile>
+#include <QPixmapCache>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QSGTexture>
+#include <QSGTextureProvider>
+#include <QSet>
+#include <utility>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// A frame is considered stable when nothing was swapped for this long
+static const int kSettleIntervalMs = 500;
+// Report anyway if the scene never settles (e.g. a running animation)
+static const int kSettleDeadlineMs = 5000;
+
+MemoryMonitor::MemoryMonitor(QObject *parent) : QObject(parent)
+{
+    m_settleTimer.setSingleShot(true);
+    m_settleTimer.setInterval(kSettleIntervalMs);
+    m_deadlineTimer.setSingleShot(true);
+    m_deadlineTimer.setInterval(kSettleDeadlineMs);
+
+    auto onSettled = [this]() {
+        if (m_stableReported) {
+            return;
+        }
+        m_stableReported = true;
+        m_settleTimer.stop();
+        m_deadlineTimer.stop();
+        if (m_window) {
+            disconnect(m_window, &QQuickWindow::frameSwapped, this, nullptr);
+        }
+        reportPhase(QStringLiteral("first-stable-frame"));
+        emit firstStableFrame();
+    };
+    connect(&m_settleTimer, &QTimer::timeout, this, onSettled);
+    connect(&m_deadlineTimer, &QTimer::timeout, this, onSettled);
+}
+
+void MemoryMonitor::attachWindow(QQuickWindow *window)
+{
+    if (!window) {
+        return;
+    }
+
+    m_window = window;
+    // frameSwapped comes from the render thread; the queued connection
+    // restarts the settle timer on the GUI thread.
+    connect(window, &QQuickWindow::frameSwapped, this, [this]() {
+        if (!m_deadlineTimer.isActive()) {
+            m_deadlineTimer.start();
+        }
+        m_settleTimer.start();
+    }, Qt::QueuedConnection);
+    connect(window, &QQuickWindow::afterSynchronizing, this, [this]() {
+        sampleTextures();
+    }, Qt::DirectConnection);
+}
+
+void MemoryMonitor::addCacheProbe(const QString &name, std::function<qint64()> probe)
+{
+    m_cacheProbes.insert(name, std::move(probe));
+}
+
+QMap<QString, qint64> MemoryMonitor::readSmapsRollup()
+{
+    QMap<QString, qint64> values;
+
+    QFile file(QStringLiteral("/proc/self/smaps_rollup"));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return values;
+    }
+
+    // Lines look like "Pss_Anon:          12345 kB"
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    for (const QByteArray &line : lines) {
+        const int colon = line.indexOf(':');
+        if (colon <= 0 || !line.endsWith(" kB")) {
+            continue;
+        }
+        const QByteArray key = line.left(colon);
+        const QByteArray value = line.mid(colon + 1, line.size() - colon - 4).trimmed();
+        bool ok = false;
+        const qint64 kb = value.toLongLong(&ok);
+        if (ok) {
+            values.insert(QString::fromLatin1(key), kb);
+        }
+    }
+
+    return values;
+}
+
+void MemoryMonitor::reportPhase(const QString &phase)
+{
+    const QMap<QString, qint64> smaps = readSmapsRollup();
+    if (smaps.isEmpty()) {
+        qWarning() << "MemoryMonitor: /proc/self/smaps_rollup is not available";
+        return;
+    }
+
+    const auto mib = [](qint64 kb) { return QString::number(kb / 1024.0, 'f', 1); };
+
+    qInfo().noquote() << QStringLiteral("MemoryMonitor: [%1] RSS %2 MiB, PSS %3 MiB (anon %4, file %5, shmem %6), private dirty %7 MiB, swap %8 MiB")
+        .arg(phase,
+             mib(smaps.value(QStringLiteral("Rss"))),
+             mib(smaps.value(QStringLiteral("Pss"))),
+             mib(smaps.value(QStringLiteral("Pss_Anon"))),
+             mib(smaps.value(QStringLiteral("Pss_File"))),
+             mib(smaps.value(QStringLiteral("Pss_Shmem"))),
+             mib(smaps.value(QStringLiteral("Private_Dirty"))),
+             mib(smaps.value(QStringLiteral("Swap"))));
+
+    // The pixmap cache only exposes its limit, not what it holds
+    QStringList caches;
+    for (auto it = m_cacheProbes.cbegin(); it != m_cacheProbes.cend(); ++it) {
+        caches << QStringLiteral("%1 %2 KiB").arg(it.key()).arg(it.value()() / 1024);
+    }
+    caches << QStringLiteral("pixmap-cache-limit %1 KiB").arg(QPixmapCache::cacheLimit());
+    qInfo().noquote() << QStringLiteral("MemoryMonitor: [%1] caches: %2").arg(phase, caches.join(QStringLiteral(", ")));
+
+    // Textures live on the render thread; sample them at the next sync
+    if (m_window) {
+        QMutexLocker locker(&m_textureMutex);
+        m_texturePhases << phase;
+        locker.unlock();
+        m_window->update();
+    }
+}
+
+void MemoryMonitor::sampleTextures()
+{
+    QMutexLocker locker(&m_textureMutex);
+    if (m_texturePhases.isEmpty()) {
+        return;
+    }
+    const QStringList phases = std::exchange(m_texturePhases, {});
+    locker.unlock();
+
+    // Images, layers and effect sources; an atlas texture counts its sub-rect
+    QSet<QSGTexture *> textures;
+    qint64 bytes = 0;
+    QList<QQuickItem *> items { m_window->contentItem() };
+    while (!items.isEmpty()) {
+        QQuickItem *item = items.takeLast();
+        items += item->childItems();
+        if (!item->isTextureProvider()) {
+            continue;
+        }
+        QSGTexture *texture = item->textureProvider()->texture();
+        if (texture && !textures.contains(texture)) {
+            textures.insert(texture);
+            const QSize size = texture->textureSize();
+            bytes += qint64(size.width()) * size.height() * 4;
+        }
+    }
+
+    for (const QString &phase : phases) {
+        qInfo().noquote() << QStringLiteral("MemoryMonitor: [%1] scene graph textures %2 KiB in %3 textures")
+                                 .arg(phase).arg(bytes / 1024).arg(textures.size());
+    }
+}
+
+void MemoryMonitor::reclaim()
+{
+    if (m_reclaimed) {
+        return;
+    }
+    m_reclaimed = true;
+
+    if (m_engine) {
+        // Drops compiled component data that is no longer referenced
+        m_engine->collectGarbage();
+        m_engine->trimComponentCache();
+    }
+
+    QPixmapCache::clear();
+
+    if (m_window) {
+        // Releases scene graph resources that are not in use (e.g. the
+        // textures of the released background source and effect layers)
+        m_window->releaseResources();
+    }
+
+#ifdef __GLIBC__
+    // Return freed heap pages (mostly image decode buffers) to the kernel
+    malloc_trim(0);
+#endif
+
+    // Let the render thread process releaseResources() before measuring
+    QTimer::singleShot(kSettleIntervalMs, this, [this]() {
+        reportPhase(QStringLiteral("reclaimed"));
+    });
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QObject>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QTimer>
+#include <functional>
+
+class QQmlEngine;
+class QQuickWindow;
+
+/**
+ * @brief Reports the greeter's memory footprint by startup phase and reclaims
+ * memory that is only needed to produce the first frame.
+ */
+class MemoryMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MemoryMonitor(QObject *parent = nullptr);
+
+    void setEngine(QQmlEngine *engine) { m_engine = engine; }
+
+    /**
+     * @brief Starts watching the window for the first stable frame, i.e. the
+     * first time no new frame is swapped for a short while.
+     */
+    void attachWindow(QQuickWindow *window);
+
+    /**
+     * @brief Registers a named cache whose size (in bytes) is included in reports.
+     */
+    void addCacheProbe(const QString &name, std::function<qint64()> probe);
+
+    /**
+     * @brief Logs an RSS/PSS breakdown from /proc/self/smaps_rollup plus cache
+     * sizes, followed by the scene graph textures once the next frame synced.
+     */
+    Q_INVOKABLE void reportPhase(const QString &phase);
+
+    /**
+     * @brief Trims the QML component cache, Qt's pixmap cache, scene graph
+     * resources and the malloc heap. Call once the UI released its sources.
+     */
+    Q_INVOKABLE void reclaim();
+
+signals:
+    // Emitted once; QML drops first-frame-only sources and then calls reclaim().
+    void firstStableFrame();
+
+private:
+    static QMap<QString, qint64> readSmapsRollup();
+    // Render thread, while the GUI thread is blocked in the sync
+    void sampleTextures();
+
+
+    QQmlEngine *m_engine = nullptr;
+    QQuickWindow *m_window = nullptr;
+    QTimer m_settleTimer;
+    QTimer m_deadlineTimer;
+    bool m_stableReported = false;
+    bool m_reclaimed = false;
+    QMutex m_textureMutex;
+    QStringList m_texturePhases;  // Phases waiting for a texture sample
+    QMap<QString, std::function<qint64()>> m_cacheProbes;
+};
@@ -0,0 +1,198 @@
+#include "MetricsExporter.h"
+#include "Instrumentation.h"
+#include <unistd.h>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QQuickWindow>
+#include <QSaveFile>
+
+namespace {
+
+// Prometheus label values escape backslash, quote and newline
+QByteArray label(const QByteArray &value)
+{
+    QByteArray escaped = value;
+    escaped.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+    return '"' + escaped + '"';
+}
+
+QByteArray seconds(double ms)
+{
+    return QByteArray::number(ms / 1000.0, 'g', 9);
+}
+
+qint64 residentBytes()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) : -1;
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter(const QString &directory, const QString &socketPath, int intervalMs,
+                                 qint64 processStartNs, QObject *parent)
+    : QObject(parent)
+    , m_seat(qEnvironmentVariable("XDG_SEAT", QStringLiteral("seat0")))
+    // One file per seat: the greeters of all seats share the directory
+    , m_filePath(directory + QStringLiteral("/qmlgreet-%1.prom").arg(m_seat))
+    , m_processStartNs(processStartNs)
+    , m_processStartUnixMs(QDateTime::currentMSecsSinceEpoch() - (Instrumentation::nowNs() - processStartNs) / 1000000)
+{
+    if (!QDir().mkpath(directory)) {
+        qWarning() << "MetricsExporter: Cannot create" << directory;
+    }
+
+    m_timer.setInterval(qMax(1000, intervalMs));
+    connect(&m_timer, &QTimer::timeout, this, &MetricsExporter::write);
+    m_timer.start();
+
+    if (!socketPath.isEmpty()) {
+        m_server = new QLocalServer(this);
+        m_server->setSocketOptions(QLocalServer::WorldAccessOption);
+        QLocalServer::removeServer(socketPath);
+        if (!m_server->listen(socketPath)) {
+            qWarning() << "MetricsExporter: Cannot listen on" << socketPath << ":" << m_server->errorString();
+        } else {
+            connect(m_server, &QLocalServer::newConnection, this, [this]() {
+                while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+                    connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+                    socket->write(render());
+                    // Closes once the text is written
+                    socket->disconnectFromServer();
+                }
+            });
+        }
+    }
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    if (m_server) {
+        m_server->close();
+    }
+}
+
+void MetricsExporter::pause()
+{
+    m_timer.stop();
+    write();
+}
+
+void MetricsExporter::resume()
+{
+    write();
+    m_timer.start();
+}
+
+void MetricsExporter::attachWindow(QQuickWindow *window)
+{
+    if (!window) {
+        return;
+    }
+
+    // Render thread: from scene graph sync to the swap
+    connect(window, &QQuickWindow::beforeSynchronizing, this, [this]() {
+        m_frameStartNs.store(Instrumentation::nowNs(), std::memory_order_relaxed);
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, [this]() {
+        Instrumentation::record("frame", m_frameStartNs.load(std::memory_order_relaxed));
+    }, Qt::DirectConnection);
+
+    m_firstFrameConnection = connect(window, &QQuickWindow::frameSwapped, this, [this]() {
+        disconnect(m_firstFrameConnection);
+        m_firstFrameNs = Instrumentation::nowNs() - m_processStartNs;
+        write();
+    }, Qt::QueuedConnection);
+}
+
+void MetricsExporter::write()
+{
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(render()) < 0 || !file.commit()) {
+        qWarning() << "MetricsExporter: Cannot write" << m_filePath << ":" << file.errorString();
+    }
+}
+
+QByteArray MetricsExporter::render() const
+{
+    const QByteArray seat = "seat=" + label(m_seat.toUtf8());
+    QByteArray out;
+
+    out += "# HELP qmlgreet_start_time_seconds Unix time the greeter started.\n"
+           "# TYPE qmlgreet_start_time_seconds gauge\n"
+           "qmlgreet_start_time_seconds{" + seat + "} " + QByteArray::number(m_processStartUnixMs / 1000.0, 'f', 3) + "\n";
+
+    if (m_firstFrameNs > 0) {
+        out += "# HELP qmlgreet_first_frame_seconds Time from process start to the first swapped frame.\n"
+               "# TYPE qmlgreet_first_frame_seconds gauge\n"
+               "qmlgreet_first_frame_seconds{" + seat + "} " + seconds(m_firstFrameNs / 1e6) + "\n";
+    }
+
+    const qint64 rss = residentBytes();
+    if (rss >= 0) {
+        out += "# HELP qmlgreet_resident_memory_bytes Resident set size.\n"
+               "# TYPE qmlgreet_resident_memory_bytes gauge\n"
+               "qmlgreet_resident_memory_bytes{" + seat + "} " + QByteArray::number(rss) + "\n";
+    }
+
+    // Frame times as quantiles; everything else as histograms so the fleet can be aggregated
+    QByteArray frames;
+    QByteArray operations;
+    Instrumentation::forEachHistogram([&](const Instrumentation::Histogram &histogram) {
+        const quint64 count = histogram.count();
+        if (count == 0) {
+            return;
+        }
+
+        const QByteArray sum = seconds(histogram.totalNs() / 1e6);
+        if (histogram.name() == "frame") {
+            for (double quantile : { 0.5, 0.9, 0.99 }) {
+                frames += "qmlgreet_frame_time_seconds{" + seat + ",quantile=\"" + QByteArray::number(quantile)
+                    + "\"} " + seconds(histogram.percentileMs(quantile)) + "\n";
+            }
+            frames += "qmlgreet_frame_time_seconds_sum{" + seat + "} " + sum + "\n"
+                + "qmlgreet_frame_time_seconds_count{" + seat + "} " + QByteArray::number(count) + "\n";
+            return;
+        }
+
+        const QByteArray labels = seat + ",operation=" + label(histogram.name());
+        quint64 cumulative = 0;
+        for (int i = 0; i < Instrumentation::Histogram::kBuckets; ++i) {
+            cumulative += histogram.bucket(i);
+            const QByteArray le = i == Instrumentation::Histogram::kBuckets - 1
+                ? QByteArray("+Inf") : seconds(Instrumentation::Histogram::bucketUpperMs(i));
+            operations += "qmlgreet_operation_duration_seconds_bucket{" + labels + ",le=\"" + le + "\"} "
+                + QByteArray::number(cumulative) + "\n";
+        }
+        operations += "qmlgreet_operation_duration_seconds_sum{" + labels + "} " + sum + "\n"
+            + "qmlgreet_operation_duration_seconds_count{" + labels + "} " + QByteArray::number(count) + "\n";
+    });
+
+    if (!frames.isEmpty()) {
+        out += "# HELP qmlgreet_frame_time_seconds Scene graph sync, render and swap time per frame.\n"
+               "# TYPE qmlgreet_frame_time_seconds summary\n" + frames;
+    }
+    if (!operations.isEmpty()) {
+        out += "# HELP qmlgreet_operation_duration_seconds Latency of model loads, greetd, D-Bus and file I/O.\n"
+               "# TYPE qmlgreet_operation_duration_seconds histogram\n" + operations;
+    }
+
+    QByteArray events;
+    Instrumentation::forEachCounter([&](const QByteArray &name, quint64 value) {
+        events += "qmlgreet_events_total{" + seat + ",event=" + label(name) + "} " + QByteArray::number(value) + "\n";
+    });
+    if (!events.isEmpty()) {
+        out += "# HELP qmlgreet_events_total Counted events such as failed logins.\n"
+               "# TYPE qmlgreet_events_total counter\n" + events;
+    }
+
+    return out;
+}
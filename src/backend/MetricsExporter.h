@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <atomic>
+
+class QLocalServer;
+class QQuickWindow;
+
+/**
+ * @brief Publishes the greeter's health in the Prometheus text format.
+ *
+ * The metrics file is rewritten periodically for node_exporter's textfile
+ * collector. It holds startup and frame timing, the Instrumentation latency
+ * histograms and counters, and the RSS. With a socket path set, every
+ * connection to it receives the same text.
+ */
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param directory Where "qmlgreet-<seat>.prom" is written
+     * @param socketPath Optional Unix socket serving the metrics, empty for none
+     */
+    MetricsExporter(const QString &directory, const QString &socketPath, int intervalMs,
+                    qint64 processStartNs, QObject *parent = nullptr);
+    ~MetricsExporter() override;
+
+    /**
+     * @brief Records time-to-first-frame and per-frame render times.
+     */
+    void attachWindow(QQuickWindow *window);
+
+    // Writes the metrics file now, e.g. right before exit
+    void write();
+
+    // Stops the periodic rewrite, e.g. while the outputs are off; both
+    // write the file once so it shows the state at the switch
+    void pause();
+    void resume();
+
+    QByteArray render() const;
+
+private:
+    const QString m_seat;
+    const QString m_filePath;
+    const qint64 m_processStartNs;
+    const qint64 m_processStartUnixMs;
+    qint64 m_firstFrameNs = 0;
+    QMetaObject::Connection m_firstFrameConnection;
+    std::atomic<qint64> m_frameStartNs { 0 };
+    QTimer m_timer;
+    QLocalServer *m_server = nullptr;
+};
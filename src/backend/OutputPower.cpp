@@ -0,0 +1,189 @@
+#include "OutputPower.h"
+#include "IdleMonitor.h"
+#include <QDebug>
+#include <QGuiApplication>
+#include <QStyleHints>
+#include <algorithm>
+#include <cstring>
+
+// Private Qt header for the Wayland display, as in LayerShell
+#include <qpa/qplatformnativeinterface.h>
+
+static const struct wl_registry_listener registry_listener = {
+    OutputPower::registryHandleGlobal,
+    OutputPower::registryHandleGlobalRemove
+};
+
+static const struct zwlr_output_power_v1_listener output_power_listener = {
+    OutputPower::outputPowerHandleMode,
+    OutputPower::outputPowerHandleFailed
+};
+
+OutputPower::OutputPower(int timeoutMs, IdleMonitor *idleMonitor, QObject *parent)
+    : QObject(parent)
+    , m_timeoutMs(timeoutMs)
+    , m_idleMonitor(idleMonitor)
+{
+    if (m_timeoutMs <= 0) {
+        return;
+    }
+
+    initWayland();
+    if (!m_powerManager) {
+        qWarning() << "OutputPower: Compositor does not support zwlr_output_power_manager_v1,"
+                   << "outputs stay on";
+        return;
+    }
+
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, [this]() { setOff(true); });
+    connect(idleMonitor, &IdleMonitor::activity, this, [this]() {
+        setOff(false);
+        m_timer.start(m_timeoutMs);
+    });
+    m_timer.start(m_timeoutMs);
+}
+
+OutputPower::~OutputPower()
+{
+    for (const Output &output : m_outputs) {
+        if (output.power) zwlr_output_power_v1_destroy(output.power);
+        wl_output_destroy(output.output);
+    }
+    if (m_powerManager) zwlr_output_power_manager_v1_destroy(m_powerManager);
+    if (m_wlRegistry) wl_registry_destroy(m_wlRegistry);
+    // Do NOT destroy m_wlDisplay; Qt owns it.
+}
+
+void OutputPower::initWayland()
+{
+    QPlatformNativeInterface *native = QGuiApplication::platformNativeInterface();
+    if (!native) {
+        return;
+    }
+
+    m_wlDisplay = static_cast<struct wl_display *>(native->nativeResourceForIntegration("wl_display"));
+    if (!m_wlDisplay) {
+        qWarning() << "OutputPower: Not running on Wayland";
+        return;
+    }
+
+    // Our own registry; Qt's wl_output proxies are not ours to attach objects to
+    m_wlRegistry = wl_display_get_registry(m_wlDisplay);
+    wl_registry_add_listener(m_wlRegistry, &registry_listener, this);
+    wl_display_roundtrip(m_wlDisplay);
+
+    if (m_powerManager) {
+        for (Output &output : m_outputs) {
+            addOutput(output.name, output.output);
+        }
+    }
+}
+
+void OutputPower::addOutput(uint32_t name, struct wl_output *output)
+{
+    auto it = std::find_if(m_outputs.begin(), m_outputs.end(), [name](const Output &o) { return o.name == name; });
+    if (it == m_outputs.end()) {
+        m_outputs.push_back({ name, output, nullptr });
+        it = m_outputs.end() - 1;
+    }
+    if (!m_powerManager || it->power) {
+        return;
+    }
+
+    it->power = zwlr_output_power_manager_v1_get_output_power(m_powerManager, output);
+    zwlr_output_power_v1_add_listener(it->power, &output_power_listener, this);
+    if (m_off) {
+        // Hotplugged while the others are off
+        zwlr_output_power_v1_set_mode(it->power, ZWLR_OUTPUT_POWER_V1_MODE_OFF);
+    }
+}
+
+void OutputPower::setOff(bool off)
+{
+    if (m_off == off) {
+        return;
+    }
+    m_off = off;
+
+    const uint32_t mode = off ? ZWLR_OUTPUT_POWER_V1_MODE_OFF : ZWLR_OUTPUT_POWER_V1_MODE_ON;
+    for (const Output &output : m_outputs) {
+        if (output.power) {
+            zwlr_output_power_v1_set_mode(output.power, mode);
+        }
+    }
+    wl_display_flush(m_wlDisplay);
+    m_idleMonitor->setConsumeInput(off);
+
+    // A blinking text cursor would keep the render loop going
+    QStyleHints *hints = QGuiApplication::styleHints();
+    if (off) {
+        m_savedCursorFlashTime = hints->cursorFlashTime();
+        hints->setCursorFlashTime(0);
+        m_offTimer.start();
+        ++m_offCount;
+        qInfo() << "OutputPower: Outputs off after" << m_timeoutMs / 1000 << "s without input";
+    } else {
+        hints->setCursorFlashTime(m_savedCursorFlashTime);
+        const qint64 offMs = m_offTimer.elapsed();
+        m_totalOffMs += offMs;
+        qInfo() << "OutputPower: Outputs on after being off for" << offMs / 1000 << "s";
+    }
+
+    emit offChanged();
+}
+
+void OutputPower::logSummary() const
+{
+    if (m_offCount == 0) {
+        return;
+    }
+    const qint64 totalMs = m_totalOffMs + (m_off ? m_offTimer.elapsed() : 0);
+    qInfo() << "OutputPower: Outputs were off" << m_offCount << "time(s) for" << totalMs / 1000 << "s in total";
+}
+
+void OutputPower::registryHandleGlobal(void *data, struct wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    (void)version; // Unused parameter
+    OutputPower *self = static_cast<OutputPower*>(data);
+    if (strcmp(interface, zwlr_output_power_manager_v1_interface.name) == 0) {
+        self->m_powerManager = (struct zwlr_output_power_manager_v1 *)wl_registry_bind(registry, name, &zwlr_output_power_manager_v1_interface, 1);
+    } else if (strcmp(interface, wl_output_interface.name) == 0) {
+        self->addOutput(name, (struct wl_output *)wl_registry_bind(registry, name, &wl_output_interface, 1));
+    }
+}
+
+void OutputPower::registryHandleGlobalRemove(void *data, struct wl_registry *registry, uint32_t name)
+{
+    (void)registry; // Unused parameter
+    OutputPower *self = static_cast<OutputPower*>(data);
+    for (auto it = self->m_outputs.begin(); it != self->m_outputs.end(); ++it) {
+        if (it->name == name) {
+            if (it->power) zwlr_output_power_v1_destroy(it->power);
+            wl_output_destroy(it->output);
+            self->m_outputs.erase(it);
+            return;
+        }
+    }
+}
+
+void OutputPower::outputPowerHandleMode(void *data, struct zwlr_output_power_v1 *power, uint32_t mode)
+{
+    (void)data;  // Unused parameter
+    (void)power; // Unused parameter
+    qDebug() << "OutputPower: Output is now" << (mode == ZWLR_OUTPUT_POWER_V1_MODE_ON ? "on" : "off");
+}
+
+void OutputPower::outputPowerHandleFailed(void *data, struct zwlr_output_power_v1 *power)
+{
+    // Unsupported output, or another client controls it
+    OutputPower *self = static_cast<OutputPower*>(data);
+    for (Output &output : self->m_outputs) {
+        if (output.power == power) {
+            qWarning() << "OutputPower: Cannot control the power of output" << output.name;
+            zwlr_output_power_v1_destroy(power);
+            output.power = nullptr;
+            return;
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <vector>
+#include <wayland-client.h>
+#include "wlr-output-power-management-unstable-v1-client-protocol.h"
+
+class IdleMonitor;
+
+/**
+ * @brief Turns the outputs off after a long idle period through
+ * zwlr_output_power_manager_v1 and back on at the first input.
+ *
+ * While the outputs are off, off is true; QML stops its timers and
+ * animations on it so the scene graph has nothing to render. Input then
+ * only turns the outputs back on and is not delivered to the UI.
+ */
+class OutputPower : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool off READ off NOTIFY offChanged)
+
+public:
+    // timeoutMs <= 0 never turns the outputs off
+    OutputPower(int timeoutMs, IdleMonitor *idleMonitor, QObject *parent = nullptr);
+    ~OutputPower() override;
+
+    bool off() const { return m_off; }
+
+    // Logs how often and for how long the outputs were off
+    void logSummary() const;
+
+    // Wayland Static Callbacks (must be public for C callback access)
+    static void registryHandleGlobal(void *data, struct wl_registry *registry, uint32_t name, const char *interface, uint32_t version);
+    static void registryHandleGlobalRemove(void *data, struct wl_registry *registry, uint32_t name);
+    static void outputPowerHandleMode(void *data, struct zwlr_output_power_v1 *power, uint32_t mode);
+    static void outputPowerHandleFailed(void *data, struct zwlr_output_power_v1 *power);
+
+signals:
+    void offChanged();
+
+private:
+    struct Output {
+        uint32_t name = 0;
+        struct wl_output *output = nullptr;
+        struct zwlr_output_power_v1 *power = nullptr;
+    };
+
+    void initWayland();
+    void addOutput(uint32_t name, struct wl_output *output);
+    void setOff(bool off);
+
+    const int m_timeoutMs;
+    IdleMonitor *m_idleMonitor;
+    QTimer m_timer;
+    bool m_off = false;
+    int m_savedCursorFlashTime = 0;
+
+    QElapsedTimer m_offTimer;
+    int m_offCount = 0;
+    qint64 m_totalOffMs = 0;
+
+    struct wl_display *m_wlDisplay = nullptr;
+    struct wl_registry *m_wlRegistry = nullptr;
+    struct zwlr_output_power_manager_v1 *m_powerManager = nullptr;
+    std::vector<Output> m_outputs;
+};
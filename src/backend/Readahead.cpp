@@ -0,0 +1,297 @@
+#include "Readahead.h"
+#include "ThreadPriority.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QStringList>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+enum Mode {
+    Off,
+    Record,
+    Replay,
+    Auto
+};
+
+Mode s_mode = Off;
+QString s_manifest;
+std::atomic<bool> s_recording { false };
+std::atomic<bool> s_recorded { false };
+
+QMutex s_notedMutex;
+QStringList s_noted;
+
+// Virtual filesystems and tmpfs are never read from disk
+const char *const kSkippedPrefixes[] = { "/proc/", "/sys/", "/dev/", "/run/", "/tmp/" };
+
+Mode parseMode(const QString &value)
+{
+    const QString normalized = value.trimmed().toLower();
+    if (normalized == QStringLiteral("off")) {
+        return Off;
+    }
+    if (normalized == QStringLiteral("record")) {
+        return Record;
+    }
+    if (normalized == QStringLiteral("replay")) {
+        return Replay;
+    }
+    if (!normalized.isEmpty() && normalized != QStringLiteral("auto")) {
+        qWarning() << "Readahead: Unknown mode" << value << ", using auto";
+    }
+    return Auto;
+}
+
+QString defaultManifest()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+        + QStringLiteral("/qmlgreet/readahead.list");
+}
+
+struct Entry {
+    QByteArray path;
+    dev_t device;
+    ino_t inode;
+    off_t size;
+};
+
+void replay(const QString &manifest)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(manifest);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    std::vector<Entry> entries;
+    int missing = 0;
+    while (!file.atEnd()) {
+        const QByteArray path = file.readLine().trimmed();
+        if (path.isEmpty() || path.startsWith('#')) {
+            continue;
+        }
+        struct stat st;
+        if (stat(path.constData(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            ++missing;
+            continue;
+        }
+        entries.push_back({ path, st.st_dev, st.st_ino, st.st_size });
+    }
+
+    // Inode order roughly follows the on-disk layout and saves seeks on
+    // rotational disks
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.device != b.device ? a.device < b.device : a.inode < b.inode;
+    });
+
+    qint64 bytes = 0;
+    for (const Entry &entry : entries) {
+        const int fd = open(entry.path.constData(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            ++missing;
+            continue;
+        }
+        // readahead() is refused by some filesystems; fadvise is the portable hint
+        if (readahead(fd, 0, entry.size) != 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        }
+        close(fd);
+        bytes += entry.size;
+    }
+
+    qInfo().noquote() << QStringLiteral("Readahead: Replayed %1 files (%2 MiB) from %3 in %4 ms, %5 missing")
+                             .arg(entries.size())
+                             .arg(double(bytes) / (1024 * 1024), 0, 'f', 1)
+                             .arg(manifest)
+                             .arg(timer.elapsed())
+                             .arg(missing);
+
+    // Files went away with an update; record the new set this time
+    if (missing > 0 && s_mode == Auto) {
+        s_recording = true;
+    }
+}
+
+// File-backed mappings: libraries, plugins, fonts (FreeType maps them),
+// the fontconfig and QML caches
+void collectMappings(QStringList *paths)
+{
+    QFile maps(QStringLiteral("/proc/self/maps"));
+    if (!maps.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    // address perms offset dev inode path
+    for (const QByteArray &line : maps.readAll().split('\n')) {
+        const int slash = line.indexOf('/');
+        if (slash < 0 || line.endsWith(" (deleted)")) {
+            continue;
+        }
+        paths->append(QFile::decodeName(line.mid(slash)));
+    }
+}
+
+void collectOpenFiles(QStringList *paths)
+{
+    const QDir fds(QStringLiteral("/proc/self/fd"));
+    for (const QString &fd : fds.entryList(QDir::Files | QDir::System)) {
+        char target[4096];
+        const ssize_t length = readlink(QFile::encodeName(fds.filePath(fd)).constData(), target, sizeof(target) - 1);
+        if (length > 0 && target[0] == '/') {
+            paths->append(QFile::decodeName(QByteArray(target, int(length))));
+        }
+    }
+}
+
+void writeManifest(const QString &manifest, QStringList paths)
+{
+    collectMappings(&paths);
+    collectOpenFiles(&paths);
+
+    QStringList entries;
+    QSet<QString> seen;
+    QSet<QString> importDirs;
+    qint64 bytes = 0;
+    const auto add = [&](const QString &path) {
+        if (seen.contains(path) || path == manifest) {
+            return;
+        }
+        seen.insert(path);
+        const QByteArray encoded = QFile::encodeName(path);
+        for (const char *prefix : kSkippedPrefixes) {
+            if (encoded.startsWith(prefix)) {
+                return;
+            }
+        }
+        struct stat st;
+        if (stat(encoded.constData(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            return;
+        }
+        entries.append(path);
+        bytes += st.st_size;
+    };
+
+    for (const QString &path : std::as_const(paths)) {
+        add(path);
+        // QML plugins are found through the qmldir next to them, which is
+        // read and closed before the plugin is mapped
+        if (path.endsWith(QStringLiteral(".so"))) {
+            const QString dir = QFileInfo(path).path();
+            if (!importDirs.contains(dir)) {
+                importDirs.insert(dir);
+                add(dir + QStringLiteral("/qmldir"));
+            }
+        }
+    }
+
+    QDir().mkpath(QFileInfo(manifest).absolutePath());
+    QSaveFile file(manifest);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Readahead: Cannot write" << manifest << ":" << file.errorString();
+        return;
+    }
+    file.write("# qmlgreet readahead manifest, one file per line\n");
+    for (const QString &entry : std::as_const(entries)) {
+        file.write(QFile::encodeName(entry) + '\n');
+    }
+    if (!file.commit()) {
+        qWarning() << "Readahead: Cannot write" << manifest << ":" << file.errorString();
+        return;
+    }
+
+    qInfo().noquote() << QStringLiteral("Readahead: Recorded %1 files (%2 MiB) to %3")
+                             .arg(entries.size())
+                             .arg(double(bytes) / (1024 * 1024), 0, 'f', 1)
+                             .arg(manifest);
+}
+
+} // namespace
+
+void Readahead::start(const QString &configPath)
+{
+    QString manifest = QStringLiteral("/var/cache/qmlgreet/readahead.list");
+    QString mode;
+    if (QFile::exists(configPath)) {
+        QSettings config(configPath, QSettings::IniFormat);
+        config.beginGroup("Behavior");
+        mode = config.value("Readahead").toString();
+        manifest = config.value("ReadaheadList", manifest).toString().trimmed();
+        config.endGroup();
+    }
+
+    s_mode = parseMode(mode);
+    if (s_mode == Off || manifest.isEmpty()) {
+        s_mode = Off;
+        return;
+    }
+
+    // Fall back to the greeter user's cache when the system cache is not writable
+    if (!QFileInfo::exists(manifest) && !QFileInfo(QFileInfo(manifest).absolutePath()).isWritable()) {
+        manifest = defaultManifest();
+    }
+    s_manifest = manifest;
+
+    const QFileInfo info(manifest);
+    if (s_mode == Record) {
+        s_recording = true;
+    } else if (s_mode == Auto) {
+        // An update replaced the greeter, and likely the libraries with it
+        s_recording = !info.exists()
+            || info.lastModified() < QFileInfo(QStringLiteral("/proc/self/exe")).lastModified();
+    }
+
+    if (s_mode != Record && info.exists()) {
+        std::thread(replay, manifest).detach();
+    }
+}
+
+bool Readahead::isRecording()
+{
+    return s_recording && !s_recorded;
+}
+
+void Readahead::note(const QString &path)
+{
+    // Stale entries are only found by the replay, so auto always collects
+    if (s_mode == Off || s_mode == Replay || s_recorded || path.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&s_notedMutex);
+    if (!s_noted.contains(path)) {
+        s_noted.append(path);
+    }
+}
+
+void Readahead::record()
+{
+    const bool recording = isRecording();
+    s_recorded = true;
+
+    QStringList noted;
+    {
+        QMutexLocker locker(&s_notedMutex);
+        noted.swap(s_noted);
+    }
+    if (!recording) {
+        return;
+    }
+    (void)ThreadPriority::run(ThreadPriority::Maintenance, [manifest = s_manifest, noted]() {
+        writeManifest(manifest, noted);
+    });
+}
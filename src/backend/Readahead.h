@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QString>
+
+/**
+ * @brief Warms the page cache with the files a greeter start reads.
+ *
+ * On spinning disks and cold eMMC much of the time to the first frame goes
+ * to page-cache misses on Qt and MauiKit libraries, QML plugins, fonts,
+ * icons and the wallpaper. A recording start writes the files it mapped,
+ * held open or noted through note() to a manifest once the first frame is
+ * up; later starts read that manifest on a thread spawned at the top of
+ * main(), in parallel with the Qt initialisation that needs the files.
+ *
+ * Modes ([Behavior] Readahead): off, record, replay, or auto, which replays
+ * and records again when the manifest is missing, older than the greeter
+ * binary or lists files that are gone.
+ */
+class Readahead
+{
+public:
+    /**
+     * @brief Reads the readahead settings from @p configPath and starts the
+     * replay thread.
+     *
+     * Called before QGuiApplication exists, so it reads the two settings
+     * itself instead of waiting for the rest of the configuration.
+     */
+    static void start(const QString &configPath);
+
+    // Whether this start writes a manifest
+    static bool isRecording();
+
+    // Adds a file that is read and closed again, so it never shows up mapped or open
+    static void note(const QString &path);
+
+    /**
+     * @brief Collects this process' file-backed mappings, open files and
+     * noted files and writes the manifest off the GUI thread.
+     */
+    static void record();
+};
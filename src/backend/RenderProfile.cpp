@@ -0,0 +1,96 @@
+#include "RenderProfile.h"
+#include <QDebug>
+#include <QQuickWindow>
+#include <QSGRendererInterface>
+#include <rhi/qrhi.h>
+
+RenderProfile::RenderProfile(const QString &mode, QObject *parent)
+    : QObject(parent)
+    , m_mode(mode.trimmed().toLower())
+{
+    if (m_mode == QStringLiteral("lowcost")) {
+        setLowCost(true, QStringLiteral("forced"));
+    } else if (m_mode == QStringLiteral("full")) {
+        setLowCost(false, QStringLiteral("forced"));
+    } else {
+        m_mode = QStringLiteral("auto");
+        detectStaticBackend();
+    }
+
+    qInfo() << "RenderProfile: mode" << m_mode << "backend" << m_backend
+            << "profile" << (m_lowCost ? "lowcost" : "full");
+}
+
+void RenderProfile::detectStaticBackend()
+{
+    // The software adaptation is selected before any window exists, either
+    // through QT_QUICK_BACKEND or QQuickWindow::setGraphicsApi().
+    if (QQuickWindow::graphicsApi() == QSGRendererInterface::Software) {
+        setLowCost(true, QStringLiteral("software"));
+        return;
+    }
+
+    // Mesa can be told to rasterise on the CPU before the context is created.
+    const QByteArray galliumDriver = qgetenv("GALLIUM_DRIVER");
+    if (qEnvironmentVariableIntValue("LIBGL_ALWAYS_SOFTWARE") == 1
+        || galliumDriver == "llvmpipe" || galliumDriver == "softpipe") {
+        setLowCost(true, QString::fromLatin1(galliumDriver.isEmpty() ? "llvmpipe" : galliumDriver));
+        return;
+    }
+
+    m_backend = QQuickWindow::sceneGraphBackend().isEmpty()
+        ? QStringLiteral("rhi") : QQuickWindow::sceneGraphBackend();
+}
+
+void RenderProfile::attachWindow(QQuickWindow *window)
+{
+    if (!window || m_mode != QStringLiteral("auto") || m_lowCost) {
+        return;
+    }
+
+    // sceneGraphInitialized is emitted on the render thread; only read the
+    // device information there and hand the result back to the GUI thread.
+    connect(window, &QQuickWindow::sceneGraphInitialized, this, [this, window]() {
+        QSGRendererInterface *rif = window->rendererInterface();
+        if (!rif) {
+            return;
+        }
+
+        if (rif->graphicsApi() == QSGRendererInterface::Software) {
+            QMetaObject::invokeMethod(this, [this]() {
+                setLowCost(true, QStringLiteral("software"));
+            }, Qt::QueuedConnection);
+            return;
+        }
+
+        auto *rhi = static_cast<QRhi *>(rif->getResource(window, QSGRendererInterface::RhiResource));
+        if (!rhi) {
+            return;
+        }
+
+        const QRhiDriverInfo info = rhi->driverInfo();
+        if (info.deviceType == QRhiDriverInfo::CpuDevice) {
+            const QString device = QString::fromUtf8(info.deviceName);
+            QMetaObject::invokeMethod(this, [this, device]() {
+                setLowCost(true, device);
+            }, Qt::QueuedConnection);
+        }
+    }, Qt::DirectConnection);
+}
+
+void RenderProfile::setLowCost(bool lowCost, const QString &backend)
+{
+    if (m_backend != backend) {
+        m_backend = backend;
+        emit backendChanged();
+    }
+    if (m_lowCost == lowCost) {
+        return;
+    }
+
+    m_lowCost = lowCost;
+    if (m_lowCost) {
+        qInfo() << "RenderProfile: Switching to low-cost profile for backend" << m_backend;
+    }
+    emit lowCostChanged();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+class QQuickWindow;
+
+/**
+ * @brief Chooses between the full and the low-cost rendering profile.
+ * The low-cost profile is meant for the software renderer and CPU rasterisers
+ * such as llvmpipe, where shader effects and animations are prohibitively slow.
+ */
+class RenderProfile : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool lowCost READ lowCost NOTIFY lowCostChanged)
+    Q_PROPERTY(QString backend READ backend NOTIFY backendChanged)
+
+public:
+    /**
+     * @param mode "auto" to detect the backend, "full" or "lowcost" to force a profile.
+     */
+    explicit RenderProfile(const QString &mode, QObject *parent = nullptr);
+
+    bool lowCost() const { return m_lowCost; }
+    QString backend() const { return m_backend; }
+
+    /**
+     * @brief Inspects the scene graph of the given window once it is initialized.
+     * Only has an effect in "auto" mode.
+     */
+    void attachWindow(QQuickWindow *window);
+
+signals:
+    void lowCostChanged();
+    void backendChanged();
+
+private:
+    void detectStaticBackend();
+    void setLowCost(bool lowCost, const QString &backend);
+
+    QString m_mode;
+    QString m_backend;
+    bool m_lowCost = false;
+};
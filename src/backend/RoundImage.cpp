@@ -0,0 +1,183 @@
+#include "RoundImage.h"
+#include "AvatarImageProvider.h"
+#include <QDebug>
+#include <QQuickWindow>
+#include <QSGImageNode>
+#include <QtConcurrent/QtConcurrentRun>
+
+AvatarImageProvider *RoundImage::s_provider = nullptr;
+
+RoundImage::RoundImage(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents, true);
+    connect(&m_watcher, &QFutureWatcher<QImage>::finished, this, &RoundImage::onLoaded);
+}
+
+RoundImage::~RoundImage()
+{
+    m_watcher.waitForFinished();
+}
+
+void RoundImage::setImageProvider(AvatarImageProvider *provider)
+{
+    s_provider = provider;
+}
+
+void RoundImage::setSource(const QUrl &source)
+{
+    if (m_source == source) {
+        return;
+    }
+
+    m_source = source;
+    emit sourceChanged();
+    load();
+}
+
+void RoundImage::setPrefetch(const QList<QUrl> &prefetch)
+{
+    if (m_prefetch == prefetch) {
+        return;
+    }
+
+    m_prefetch = prefetch;
+    emit prefetchChanged();
+    // Otherwise onLoaded() starts it, once the visible avatar is decoded
+    if (!m_watcher.isRunning()) {
+        startPrefetch();
+    }
+}
+
+void RoundImage::startPrefetch()
+{
+    const QSize size = pixelSize();
+    if (!s_provider || size.isEmpty()) {
+        return;
+    }
+    for (const QUrl &url : std::as_const(m_prefetch)) {
+        if (!url.isEmpty()) {
+            s_provider->prefetch(providerId(url), size);
+        }
+    }
+}
+
+QSize RoundImage::pixelSize() const
+{
+    const qreal ratio = window() ? window()->effectiveDevicePixelRatio() : 1.0;
+    return QSize(qRound(width() * ratio), qRound(height() * ratio));
+}
+
+QString RoundImage::providerId(const QUrl &url)
+{
+    if (!url.isLocalFile()) {
+        return url.toString();
+    }
+    return url.hasFragment() ? url.toLocalFile() + QLatin1Char('#') + url.fragment() : url.toLocalFile();
+}
+
+void RoundImage::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        load();
+    }
+}
+
+void RoundImage::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    QQuickItem::itemChange(change, value);
+    // The pixel size depends on the window's device pixel ratio
+    if (change == ItemDevicePixelRatioHasChanged || change == ItemSceneChange) {
+        load();
+    }
+}
+
+void RoundImage::load()
+{
+    const QSize targetSize = pixelSize();
+
+    if (m_source.isEmpty() || targetSize.isEmpty() || !s_provider) {
+        m_requested = {};
+        m_requestedSize = QSize();
+        m_image = QImage();
+        m_imageChanged = true;
+        setStatus(Null);
+        update();
+        return;
+    }
+    if (m_source == m_requested && targetSize == m_requestedSize) {
+        return;
+    }
+
+    // One decode at a time; onLoaded() starts the latest request
+    if (m_watcher.isRunning()) {
+        return;
+    }
+
+    m_requested = m_source;
+    m_requestedSize = targetSize;
+
+    const QString id = providerId(m_source);
+    AvatarImageProvider *provider = s_provider;
+    setStatus(Loading);
+    m_watcher.setFuture(QtConcurrent::run([provider, id, targetSize]() {
+        return provider->requestImage(id, nullptr, targetSize);
+    }));
+}
+
+void RoundImage::onLoaded()
+{
+    // Cleared while decoding; load() already dropped the image
+    if (m_source.isEmpty() || !s_provider || pixelSize().isEmpty()) {
+        return;
+    }
+    // Source or size changed while decoding, unless they changed back
+    if (m_source != m_requested || pixelSize() != m_requestedSize) {
+        load();
+        return;
+    }
+
+    m_image = m_watcher.result();
+    m_imageChanged = true;
+    setStatus(m_image.isNull() ? Error : Ready);
+    update();
+
+    // Neighbours are decoded once the visible image is done, at the same size
+    startPrefetch();
+}
+
+void RoundImage::setStatus(Status status)
+{
+    if (m_status != status) {
+        m_status = status;
+        emit statusChanged();
+    }
+}
+
+QSGNode *RoundImage::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data);
+
+    if (m_image.isNull()) {
+        delete oldNode;
+        return nullptr;
+    }
+
+    auto *node = static_cast<QSGImageNode *>(oldNode);
+    if (!node) {
+        node = window()->createImageNode();
+        node->setOwnsTexture(true);
+        node->setFiltering(QSGTexture::Linear);
+        m_imageChanged = true;
+    }
+
+    // The texture is only rebuilt when a new image arrived
+    if (m_imageChanged) {
+        node->setTexture(window()->createTextureFromImage(m_image, QQuickWindow::TextureHasAlphaChannel));
+        m_imageChanged = false;
+    }
+    node->setRect(boundingRect());
+
+    return node;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QFutureWatcher>
+#include <QImage>
+#include <QQuickItem>
+#include <QUrl>
+
+class AvatarImageProvider;
+
+/**
+ * @brief Shows an image clipped to a circle with an antialiased edge.
+ *
+ * Replaces Image + OpacityMask: the image is decoded and clipped on a worker
+ * thread at the item's pixel size (through AvatarImageProvider, so results
+ * are cached and shared between seats) and drawn as a single texture node.
+ * Works on every scene graph backend, including software.
+ */
+class RoundImage : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(Status status READ status NOTIFY statusChanged)
+    // Sources likely to be shown next, decoded ahead at this item's size
+    Q_PROPERTY(QList<QUrl> prefetch READ prefetch WRITE setPrefetch NOTIFY prefetchChanged)
+
+public:
+    enum Status { Null, Ready, Loading, Error };
+    Q_ENUM(Status)
+
+    explicit RoundImage(QQuickItem *parent = nullptr);
+    ~RoundImage() override;
+
+    // Where decoded avatars come from; set once before QML is loaded
+    static void setImageProvider(AvatarImageProvider *provider);
+
+    QUrl source() const { return m_source; }
+    void setSource(const QUrl &source);
+    Status status() const { return m_status; }
+    QList<QUrl> prefetch() const { return m_prefetch; }
+    void setPrefetch(const QList<QUrl> &prefetch);
+
+signals:
+    void sourceChanged();
+    void statusChanged();
+    void prefetchChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+
+private:
+    void load();
+    void onLoaded();
+    void startPrefetch();
+    void setStatus(Status status);
+    QSize pixelSize() const;
+
+    // Same ids as "image://avatar/<path>"; a fragment is kept as the revision
+    static QString providerId(const QUrl &url);
+
+    static AvatarImageProvider *s_provider;
+
+    QUrl m_source;
+    QList<QUrl> m_prefetch;
+    Status m_status = Null;
+    // What the image being shown or decoded was requested for
+    QUrl m_requested;
+    QSize m_requestedSize;
+    QImage m_image;
+    bool m_imageChanged = false;
+    QFutureWatcher<QImage> m_watcher;
+};
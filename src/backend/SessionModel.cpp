@@ -1,14 +1,21 @@
 #include "SessionModel.h"
+#include "StartupScheduler.h"
+#include "Instrumentation.h"
 #include <QDir>
 #include <QSettings>
 #include <QStandardPaths>
 #include <QDebug>
 
 SessionModel::SessionModel(QObject *parent) : QAbstractListModel(parent) {
-    refresh();
+    // The session list is not needed for the first frame; the combo box
+    // picks the default session up from modelReset.
+    StartupScheduler::schedule(StartupScheduler::PostFirstFrame, QStringLiteral("sessions"), this, [this]() {
+        refresh();
+    });
 }
 
 void SessionModel::refresh() {
+    LATENCY_SCOPE("model.sessions");
     beginResetModel();
     m_sessions.clear();
 
@@ -41,6 +48,7 @@ void SessionModel::loadSessionsFrom(const QString &path, const QString &type) {
     dir.setNameFilters(QStringList() << "*.desktop");
     
     for (const QString &filename : dir.entryList()) {
+        LATENCY_SCOPE("desktop.session");
         QSettings desktopFile(dir.absoluteFilePath(filename), QSettings::IniFormat);
         desktopFile.beginGroup("Desktop Entry");
         
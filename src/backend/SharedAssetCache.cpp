@@ -0,0 +1,343 @@
+#include "SharedAssetCache.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[8] = { 'Q', 'G', 'A', 'S', 'S', 'E', 'T', '1' };
+constexpr QImage::Format kFormat = QImage::Format_RGBA8888_Premultiplied;
+
+constexpr qint64 kStaleTempSecs = 60;
+constexpr qint64 kUnusedEntrySecs = 7 * 24 * 60 * 60;
+
+struct EntryHeader {
+    char magic[8];
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+    quint32 format;
+    quint64 dataSize;
+    char reserved[32];
+};
+static_assert(sizeof(EntryHeader) == 64, "pixel data must start 64-byte aligned");
+
+struct Mapping {
+    void *base;
+    size_t length;
+};
+
+std::atomic<qint64> s_mappedBytes { 0 };
+std::atomic<quint32> s_publishCounter { 0 };
+
+void unmapEntry(void *info)
+{
+    auto *mapping = static_cast<Mapping *>(info);
+    munmap(mapping->base, mapping->length);
+    s_mappedBytes.fetch_sub(qint64(mapping->length));
+    delete mapping;
+}
+
+bool writeAll(int fd, const char *data, size_t length)
+{
+    while (length > 0) {
+        const ssize_t written = ::write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= size_t(written);
+    }
+    return true;
+}
+
+bool ensureDirectory(const QString &path, mode_t mode)
+{
+    const QByteArray nativePath = QFile::encodeName(path);
+    if (::mkdir(nativePath.constData(), mode) != 0 && errno != EEXIST) {
+        return false;
+    }
+    return ::access(nativePath.constData(), W_OK | X_OK) == 0;
+}
+
+} // namespace
+
+SharedAssetCache::SharedAssetCache(const QString &directory, qint64 byteLimit)
+    : m_directory(directory)
+    , m_byteLimit(byteLimit)
+{
+    if (isEnabled()) {
+        qInfo().noquote() << QStringLiteral("SharedAssetCache: Sharing decoded images through %1 (limit %2 MiB)")
+                                 .arg(m_directory)
+                                 .arg(m_byteLimit / (1024 * 1024));
+    }
+}
+
+QString SharedAssetCache::defaultDirectory(const QString &preferred)
+{
+    if (preferred.isEmpty()) {
+        return QString();
+    }
+    if (ensureDirectory(preferred, 0755)) {
+        return preferred;
+    }
+
+    // All greeter instances usually run as the same user, so its runtime
+    // directory still shares entries between seats
+    const QString runtimeDir = qEnvironmentVariable("XDG_RUNTIME_DIR");
+    if (!runtimeDir.isEmpty() && ensureDirectory(runtimeDir + QStringLiteral("/qmlgreet"), 0700)) {
+        return runtimeDir + QStringLiteral("/qmlgreet");
+    }
+
+    qWarning() << "SharedAssetCache: Neither" << preferred << "nor the runtime directory is writable, cache disabled";
+    return QString();
+}
+
+QByteArray SharedAssetCache::keyFor(const QString &kind, const QString &sourcePath, const QByteArray &params)
+{
+    struct stat st;
+    if (sourcePath.isEmpty() || ::stat(QFile::encodeName(sourcePath).constData(), &st) != 0) {
+        return QByteArray();
+    }
+
+    // The source is identified by inode, size and mtime rather than by hashing
+    // its bytes, which would cost as much as decoding it
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(kind.toUtf8());
+    hash.addData(QFile::encodeName(sourcePath));
+    hash.addData(QByteArray::number(quint64(st.st_dev)) + ':' + QByteArray::number(quint64(st.st_ino)));
+    hash.addData(QByteArray::number(qint64(st.st_size)));
+    hash.addData(QByteArray::number(qint64(st.st_mtim.tv_sec)) + '.' + QByteArray::number(qint64(st.st_mtim.tv_nsec)));
+    hash.addData(params);
+    hash.addData(QByteArray(kMagic, sizeof(kMagic)));
+    return hash.result().toHex().left(40);
+}
+
+QString SharedAssetCache::entryPath(const QByteArray &key) const
+{
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(key) + QStringLiteral(".img");
+}
+
+QImage SharedAssetCache::find(const QByteArray &key) const
+{
+    if (!isEnabled() || key.isEmpty()) {
+        return QImage();
+    }
+
+    const QByteArray path = QFile::encodeName(entryPath(key));
+    const int fd = ::open(path.constData(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0) {
+        return QImage();
+    }
+
+    struct stat st;
+    // Only trust entries written by this user (or root); anything else could
+    // be a spoofed background planted by another local user
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)
+        || (st.st_uid != ::geteuid() && st.st_uid != 0)
+        || size_t(st.st_size) < sizeof(EntryHeader)) {
+        ::close(fd);
+        return QImage();
+    }
+
+    const size_t length = size_t(st.st_size);
+    void *base = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        return QImage();
+    }
+
+    EntryHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    const bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+        && header.format == quint32(kFormat)
+        && header.width > 0 && header.height > 0
+        && header.bytesPerLine >= header.width * 4
+        && header.dataSize == quint64(header.bytesPerLine) * header.height
+        && sizeof(EntryHeader) + header.dataSize <= length;
+    if (!valid) {
+        qWarning() << "SharedAssetCache: Ignoring malformed entry" << path;
+        ::munmap(base, length);
+        return QImage();
+    }
+
+    // Keeps the entry from being pruned while it is in use
+    ::utimensat(AT_FDCWD, path.constData(), nullptr, 0);
+
+    s_mappedBytes.fetch_add(qint64(length));
+    const auto *pixels = static_cast<const uchar *>(base) + sizeof(EntryHeader);
+    return QImage(pixels, int(header.width), int(header.height), int(header.bytesPerLine), kFormat,
+                  unmapEntry, new Mapping { base, length });
+}
+
+QImage SharedAssetCache::findOrCreate(const QByteArray &key, const std::function<QImage()> &produce)
+{
+    if (!isEnabled() || key.isEmpty()) {
+        return produce();
+    }
+
+    QImage shared = find(key);
+    if (!shared.isNull()) {
+        return shared;
+    }
+
+    const QByteArray marker = QFile::encodeName(entryPath(key) + QStringLiteral(".fill"));
+    int markerFd = ::open(marker.constData(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (markerFd >= 0) {
+        // Another instance holding the lock is producing this entry; sleep
+        // until it is done (or gone) and take what it published
+        const bool waited = ::flock(markerFd, LOCK_EX | LOCK_NB) != 0;
+        if (waited && ::flock(markerFd, LOCK_EX) != 0) {
+            ::close(markerFd);
+            markerFd = -1;
+        } else {
+            shared = find(key);
+            if (!shared.isNull()) {
+                ::close(markerFd);
+                if (waited) {
+                    qDebug() << "SharedAssetCache: Reused entry" << key << "after waiting for its producer";
+                }
+                return shared;
+            }
+        }
+    }
+
+    const QImage produced = produce();
+    if (!produced.isNull()) {
+        shared = publish(key, produced);
+    }
+
+    if (markerFd >= 0) {
+        ::unlink(marker.constData());
+        ::close(markerFd);
+    }
+
+    // Keeps the directory within its budget as it grows, not only at idle
+    if (!shared.isNull()) {
+        prune();
+    }
+
+    return shared.isNull() ? produced : shared;
+}
+
+QImage SharedAssetCache::publish(const QByteArray &key, const QImage &image) const
+{
+    const QImage rgba = image.convertToFormat(kFormat);
+
+    EntryHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.width = quint32(rgba.width());
+    header.height = quint32(rgba.height());
+    header.bytesPerLine = quint32(rgba.bytesPerLine());
+    header.format = quint32(kFormat);
+    header.dataSize = quint64(rgba.sizeInBytes());
+
+    const QString finalPath = entryPath(key);
+    const QByteArray nativeFinal = QFile::encodeName(finalPath);
+    const QByteArray nativeTemp = QFile::encodeName(QStringLiteral("%1.tmp.%2.%3")
+        .arg(finalPath).arg(::getpid()).arg(s_publishCounter.fetch_add(1)));
+
+    const int fd = ::open(nativeTemp.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        qWarning() << "SharedAssetCache: Cannot create" << nativeTemp << ":" << strerror(errno);
+        return QImage();
+    }
+
+    const bool written = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header))
+        && writeAll(fd, reinterpret_cast<const char *>(rgba.constBits()), size_t(rgba.sizeInBytes()));
+    ::close(fd);
+
+    if (!written) {
+        qWarning() << "SharedAssetCache: Cannot write" << nativeTemp << ":" << strerror(errno);
+        ::unlink(nativeTemp.constData());
+        return QImage();
+    }
+
+    // link() never replaces an existing entry, so the first publisher wins
+    // and readers never observe a partially written file
+    if (::link(nativeTemp.constData(), nativeFinal.constData()) != 0 && errno != EEXIST) {
+        qWarning() << "SharedAssetCache: Cannot publish" << nativeFinal << ":" << strerror(errno);
+    }
+    ::unlink(nativeTemp.constData());
+
+    return find(key);
+}
+
+void SharedAssetCache::prune() const
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    struct Entry {
+        QByteArray path;
+        qint64 size;
+        struct timespec used;
+    };
+
+    const qint64 now = ::time(nullptr);
+    const QDir dir(m_directory);
+    std::vector<Entry> entries;
+    qint64 bytes = 0;
+    int removed = 0;
+
+    for (const QString &name : dir.entryList(QDir::Files | QDir::Hidden)) {
+        const QByteArray path = QFile::encodeName(dir.absoluteFilePath(name));
+        struct stat st;
+        if (::lstat(path.constData(), &st) != 0 || st.st_uid != ::geteuid()) {
+            continue;
+        }
+
+        const bool leftover = (name.contains(QStringLiteral(".tmp.")) || name.endsWith(QStringLiteral(".fill")))
+            && now - st.st_mtime > kStaleTempSecs;
+        const bool unused = name.endsWith(QStringLiteral(".img")) && now - st.st_mtime > kUnusedEntrySecs;
+
+        // Instances that still map an unlinked entry keep their pages
+        if (leftover || unused) {
+            if (::unlink(path.constData()) == 0) {
+                ++removed;
+            }
+        } else if (name.endsWith(QStringLiteral(".img"))) {
+            entries.push_back({ path, qint64(st.st_size), st.st_mtim });
+            bytes += st.st_size;
+        }
+    }
+
+    // find() touches the mtime, so the oldest mtime is the least recently used
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.used.tv_sec != b.used.tv_sec ? a.used.tv_sec < b.used.tv_sec : a.used.tv_nsec < b.used.tv_nsec;
+    });
+    for (size_t i = 0; bytes > m_byteLimit && i + 1 < entries.size(); ++i) {
+        if (::unlink(entries[i].path.constData()) == 0) {
+            bytes -= entries[i].size;
+            ++removed;
+        }
+    }
+
+    if (removed > 0) {
+        qInfo().noquote() << QStringLiteral("SharedAssetCache: Pruned %1 file(s) from %2, %3 MiB left")
+                                 .arg(removed)
+                                 .arg(m_directory)
+                                 .arg(double(bytes) / (1024 * 1024), 0, 'f', 1);
+    }
+}
+
+qint64 SharedAssetCache::mappedBytes()
+{
+    return s_mappedBytes.load();
+}
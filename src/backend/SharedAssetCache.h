@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Decoded image buffers shared between greeter instances on one host.
+ *
+ * Entries are raw RGBA files in a runtime directory (normally /run/qmlgreet),
+ * named by a hash of the source file identity and the processing parameters.
+ * Instances map them read-only, so every seat shares the same pages.
+ *
+ * Publishing is lock-free: an entry is written to a private temporary file and
+ * link()ed into place, so a visible entry is always complete and the first
+ * publisher wins. The producer holds an flock() on a fill marker, so later
+ * instances sleep until it is done instead of decoding the same image in
+ * parallel; the kernel drops the lock if the producer dies.
+ *
+ * The runtime directory is a tmpfs without a size limit, so every publish
+ * prunes the least recently used entries beyond a byte budget.
+ */
+class SharedAssetCache
+{
+public:
+    // An empty directory disables the cache; @p byteLimit bounds its entries
+    explicit SharedAssetCache(const QString &directory, qint64 byteLimit = 128 * 1024 * 1024);
+
+    bool isEnabled() const { return !m_directory.isEmpty(); }
+    QString directory() const { return m_directory; }
+
+    /**
+     * @brief Returns a key for an asset derived from @p sourcePath, or an
+     * empty key if the source cannot be identified.
+     */
+    static QByteArray keyFor(const QString &kind, const QString &sourcePath, const QByteArray &params);
+
+    // Returns the mapped entry, or a null image
+    QImage find(const QByteArray &key) const;
+
+    /**
+     * @brief Returns the shared entry for @p key, producing and publishing it
+     * if no instance has done so yet. Falls back to @p produce's private
+     * result when the cache is unavailable.
+     */
+    QImage findOrCreate(const QByteArray &key, const std::function<QImage()> &produce);
+
+    /**
+     * @brief Removes leftovers of interrupted publishes and entries unused for
+     * a week, then the least recently used entries until the rest fit the
+     * byte limit. The most recently used entry is always kept.
+     */
+    void prune() const;
+
+    // Bytes currently mapped by this process
+    static qint64 mappedBytes();
+
+    // Picks /run/qmlgreet when writable, else $XDG_RUNTIME_DIR/qmlgreet
+    static QString defaultDirectory(const QString &preferred);
+
+private:
+    QString entryPath(const QByteArray &key) const;
+    QImage publish(const QByteArray &key, const QImage &image) const;
+
+    QString m_directory;
+    qint64 m_byteLimit;
+};
@@ -0,0 +1,20 @@
+#include "SlideshowImageProvider.h"
+#include "WallpaperSlideshow.h"
+
+SlideshowImageProvider::SlideshowImageProvider(WallpaperSlideshow *slideshow)
+    : QQuickImageProvider(QQuickImageProvider::Image)
+    , m_slideshow(slideshow)
+{
+}
+
+QImage SlideshowImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    Q_UNUSED(requestedSize);
+
+    // Already decoded at output size; never rescaled here
+    const QImage image = m_slideshow->image(id.toInt());
+    if (size) {
+        *size = image.size();
+    }
+    return image;
+}
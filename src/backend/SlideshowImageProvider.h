@@ -0,0 +1,21 @@
+#pragma once
+
+#include <QQuickImageProvider>
+
+class WallpaperSlideshow;
+
+/**
+ * @brief Serves the images decoded by WallpaperSlideshow.
+ * Request as "image://slideshow/<serial>"; only the shown image and the one
+ * fading out are available.
+ */
+class SlideshowImageProvider : public QQuickImageProvider
+{
+public:
+    explicit SlideshowImageProvider(WallpaperSlideshow *slideshow);
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+
+private:
+    WallpaperSlideshow *m_slideshow;
+};
@@ -0,0 +1,358 @@
+#include "SplashSurface.h"
+#include "Instrumentation.h"
+#include "ThreadPriority.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QPointer>
+#include <QQuickItem>
+#include <QQuickItemGrabResult>
+#include <QQuickWindow>
+#include <QSaveFile>
+#include <QSettings>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <cstring>
+
+namespace {
+
+// Cache file layout; the pixels start right after it, so the file itself
+// can back the wl_shm pool
+struct SplashHeader {
+    char magic[8];
+    quint32 width;
+    quint32 height;
+    quint32 stride;
+    quint32 format; // wl_shm format
+    char key[32];   // SHA-256 of what was rendered
+    char reserved[8];
+};
+static_assert(sizeof(SplashHeader) == 64, "splash header must stay 64 bytes");
+
+constexpr char kMagic[8] = { 'Q', 'G', 'S', 'P', 'L', 'S', 'H', '1' };
+
+// How long updateCache waits for the background image to finish loading
+constexpr int kReadyPollMs = 250;
+constexpr int kReadyPollAttempts = 40;
+
+bool readHeader(int fd, SplashHeader *header)
+{
+    if (pread(fd, header, sizeof(*header), 0) != sizeof(*header)) {
+        return false;
+    }
+    return memcmp(header->magic, kMagic, sizeof(kMagic)) == 0
+        && header->width > 0 && header->height > 0
+        && header->stride >= header->width * 4;
+}
+
+void writeCache(const QString &cachePath, const QImage &image, const QByteArray &key)
+{
+    LATENCY_SCOPE("splash.write");
+    SplashHeader header = {};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.width = image.width();
+    header.height = image.height();
+    header.stride = image.bytesPerLine();
+    header.format = WL_SHM_FORMAT_XRGB8888;
+    memcpy(header.key, key.constData(), qMin<qsizetype>(key.size(), sizeof(header.key)));
+
+    QDir().mkpath(QFileInfo(cachePath).absolutePath());
+
+    // Renamed into place: a splash still showing the previous file keeps its inode
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)
+        || file.write(reinterpret_cast<const char *>(image.constBits()), image.sizeInBytes()) != image.sizeInBytes()
+        || !file.commit()) {
+        qWarning() << "SplashSurface: Cannot write" << cachePath << ":" << file.errorString();
+        return;
+    }
+    qInfo() << "SplashSurface: Cached" << image.size() << "splash in" << cachePath;
+}
+
+void grabWhenReady(QPointer<QQuickItem> background, const QString &cachePath, const QByteArray &key, int attempts)
+{
+    if (!background || !background->window()) {
+        return;
+    }
+
+    // The wallpaper decodes asynchronously; an empty background is not worth caching
+    if (!background->property("ready").toBool()) {
+        if (attempts > 0) {
+            QTimer::singleShot(kReadyPollMs, background, [=]() {
+                grabWhenReady(background, cachePath, key, attempts - 1);
+            });
+        } else {
+            qDebug() << "SplashSurface: Background never became ready, cache not updated";
+        }
+        return;
+    }
+
+    const qreal ratio = background->window()->devicePixelRatio();
+    const QSize pixelSize(qRound(background->width() * ratio), qRound(background->height() * ratio));
+    const QSharedPointer<QQuickItemGrabResult> grab = background->grabToImage(pixelSize);
+    if (!grab) {
+        return;
+    }
+    QObject::connect(grab.data(), &QQuickItemGrabResult::ready, background, [grab, cachePath, key]() {
+        const QImage image = grab->image();
+        (void)ThreadPriority::run(ThreadPriority::Maintenance, [image, cachePath, key]() {
+            // The splash is opaque; XRGB lets the compositor skip blending it
+            writeCache(cachePath, image.convertToFormat(QImage::Format_RGB32), key);
+        });
+    });
+}
+
+} // namespace
+
+static const struct wl_registry_listener registry_listener = {
+    SplashSurface::registryHandleGlobal,
+    SplashSurface::registryHandleGlobalRemove
+};
+
+static const struct zwlr_layer_surface_v1_listener layer_surface_listener = {
+    SplashSurface::layerSurfaceHandleConfigure,
+    SplashSurface::layerSurfaceHandleClosed
+};
+
+SplashSurface::SplashSurface(const QString &cachePath)
+{
+    const qint64 startNs = Instrumentation::nowNs();
+    if (show(cachePath)) {
+        qInfo() << "SplashSurface: Presented" << m_width << "x" << m_height << "splash in"
+                << (Instrumentation::nowNs() - startNs) / 1000000.0 << "ms";
+    }
+}
+
+SplashSurface::~SplashSurface()
+{
+    m_notifier.reset();
+    if (m_viewport) wp_viewport_destroy(m_viewport);
+    if (m_layerSurface) zwlr_layer_surface_v1_destroy(m_layerSurface);
+    if (m_wlSurface) wl_surface_destroy(m_wlSurface);
+    if (m_buffer) wl_buffer_destroy(m_buffer);
+    if (m_pool) wl_shm_pool_destroy(m_pool);
+    if (m_viewporter) wp_viewporter_destroy(m_viewporter);
+    if (m_layerShell) zwlr_layer_shell_v1_destroy(m_layerShell);
+    if (m_shm) wl_shm_destroy(m_shm);
+    if (m_compositor) wl_compositor_destroy(m_compositor);
+    if (m_wlRegistry) wl_registry_destroy(m_wlRegistry);
+    if (m_wlDisplay) {
+        wl_display_flush(m_wlDisplay);
+        wl_display_disconnect(m_wlDisplay);
+    }
+}
+
+bool SplashSurface::show(const QString &cachePath)
+{
+    LATENCY_SCOPE("splash.show");
+
+    // O_RDWR: compositors map shm pools read-write
+    const QByteArray nativePath = QFile::encodeName(cachePath);
+    const int fd = open(nativePath.constData(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        qDebug() << "SplashSurface: No splash cached in" << cachePath;
+        return false;
+    }
+
+    SplashHeader header;
+    struct stat st;
+    if (!readHeader(fd, &header) || fstat(fd, &st) != 0
+        || st.st_size < qint64(sizeof(header)) + qint64(header.stride) * header.height) {
+        qWarning() << "SplashSurface: Ignoring invalid splash cache" << cachePath;
+        close(fd);
+        return false;
+    }
+
+    // A connection of our own: Qt has not created its window yet, and a
+    // protocol error here must not take the greeter down with it
+    m_wlDisplay = wl_display_connect(nullptr);
+    if (!m_wlDisplay) {
+        qWarning() << "SplashSurface: Cannot connect to the Wayland display";
+        close(fd);
+        return false;
+    }
+
+    m_wlRegistry = wl_display_get_registry(m_wlDisplay);
+    wl_registry_add_listener(m_wlRegistry, &registry_listener, this);
+    wl_display_roundtrip(m_wlDisplay);
+
+    if (!m_compositor || !m_shm || !m_layerShell) {
+        qWarning() << "SplashSurface: Compositor lacks wl_shm or zwlr_layer_shell_v1, no splash";
+        close(fd);
+        return false;
+    }
+
+    // Same placement as LayerShell, but the splash never takes the keyboard
+    m_wlSurface = wl_compositor_create_surface(m_compositor);
+    m_layerSurface = zwlr_layer_shell_v1_get_layer_surface(m_layerShell, m_wlSurface, nullptr,
+                                                           ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, "login-splash");
+    zwlr_layer_surface_v1_set_size(m_layerSurface, 0, 0);
+    zwlr_layer_surface_v1_set_anchor(m_layerSurface, 15);
+    zwlr_layer_surface_v1_set_exclusive_zone(m_layerSurface, -1);
+    zwlr_layer_surface_v1_set_keyboard_interactivity(m_layerSurface, ZWLR_LAYER_SURFACE_V1_KEYBOARD_INTERACTIVITY_NONE);
+    zwlr_layer_surface_v1_add_listener(m_layerSurface, &layer_surface_listener, this);
+    wl_surface_commit(m_wlSurface);
+    wl_display_roundtrip(m_wlDisplay);
+
+    if (!m_configured) {
+        qWarning() << "SplashSurface: Layer surface was not configured";
+        close(fd);
+        return false;
+    }
+
+    // The compositor maps the cache file directly; libwayland sends a
+    // duplicate of the descriptor, so ours can go right away
+    m_pool = wl_shm_create_pool(m_shm, fd, int32_t(st.st_size));
+    close(fd);
+    m_buffer = wl_shm_pool_create_buffer(m_pool, sizeof(header), header.width, header.height,
+                                         header.stride, header.format);
+
+    // The cache is in physical pixels; map it onto the logical surface size
+    if (m_viewporter && m_width > 0 && m_height > 0) {
+        m_viewport = wp_viewporter_get_viewport(m_viewporter, m_wlSurface);
+        wp_viewport_set_destination(m_viewport, m_width, m_height);
+    } else if (m_width > 0 && header.width % m_width == 0 && header.width > m_width) {
+        wl_surface_set_buffer_scale(m_wlSurface, header.width / m_width);
+    }
+
+    wl_surface_attach(m_wlSurface, m_buffer, 0, 0);
+    wl_surface_damage_buffer(m_wlSurface, 0, 0, header.width, header.height);
+    wl_surface_commit(m_wlSurface);
+    wl_display_flush(m_wlDisplay);
+    return true;
+}
+
+void SplashSurface::startDispatch()
+{
+    if (!m_wlDisplay || m_notifier) {
+        return;
+    }
+    // The connection is ours to service until the splash goes; events that
+    // arrived while Qt started are still unread on the socket
+    m_notifier = std::make_unique<QSocketNotifier>(wl_display_get_fd(m_wlDisplay), QSocketNotifier::Read);
+    QObject::connect(m_notifier.get(), &QSocketNotifier::activated, m_notifier.get(), [this]() { dispatch(); });
+    wl_display_dispatch_pending(m_wlDisplay);
+    wl_display_flush(m_wlDisplay);
+}
+
+QString SplashSurface::cachePath(const QString &configPath)
+{
+    QString path = QStringLiteral("/var/cache/qmlgreet/splash.raw");
+    if (QFile::exists(configPath)) {
+        QSettings config(configPath, QSettings::IniFormat);
+        config.beginGroup("Appearance");
+        path = config.value("SplashCache", path).toString().trimmed();
+        config.endGroup();
+    }
+    if (path.isEmpty()) {
+        return path;
+    }
+
+    // Fall back to the greeter user's cache when the system cache is not
+    // writable; no application name is set yet, so spell out the directory
+    if (!QFileInfo(QFileInfo(path).absolutePath()).isWritable()) {
+        path = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + QStringLiteral("/qmlgreet/splash.raw");
+    }
+    return path;
+}
+
+void SplashSurface::dispatch()
+{
+    if (wl_display_dispatch(m_wlDisplay) < 0) {
+        qWarning() << "SplashSurface: Wayland connection failed:" << strerror(wl_display_get_error(m_wlDisplay));
+        m_notifier->setEnabled(false);
+        return;
+    }
+    wl_display_flush(m_wlDisplay);
+}
+
+QByteArray SplashSurface::cachedKey(const QString &cachePath)
+{
+    const QByteArray nativePath = QFile::encodeName(cachePath);
+    const int fd = open(nativePath.constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return QByteArray();
+    }
+    SplashHeader header;
+    const bool valid = readHeader(fd, &header);
+    close(fd);
+    return valid ? QByteArray(header.key, sizeof(header.key)) : QByteArray();
+}
+
+void SplashSurface::updateCache(QQuickItem *background, const QString &cachePath, const QByteArray &sourceKey)
+{
+    if (!background || !background->window()) {
+        return;
+    }
+
+    const qreal ratio = background->window()->devicePixelRatio();
+    const QSize pixelSize(qRound(background->width() * ratio), qRound(background->height() * ratio));
+    if (pixelSize.isEmpty()) {
+        return;
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(sourceKey);
+    hash.addData(QByteArray::number(pixelSize.width()) + 'x' + QByteArray::number(pixelSize.height()));
+    const QByteArray key = hash.result();
+    if (cachedKey(cachePath) == key) {
+        qDebug() << "SplashSurface: Cached splash is current";
+        return;
+    }
+
+    grabWhenReady(background, cachePath, key, kReadyPollAttempts);
+}
+
+void SplashSurface::registryHandleGlobal(void *data, struct wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    SplashSurface *self = static_cast<SplashSurface*>(data);
+    if (strcmp(interface, wl_compositor_interface.name) == 0 && version >= 4) {
+        // Version 4 for wl_surface.damage_buffer
+        self->m_compositor = (struct wl_compositor *)wl_registry_bind(registry, name, &wl_compositor_interface, 4);
+    } else if (strcmp(interface, wl_shm_interface.name) == 0) {
+        self->m_shm = (struct wl_shm *)wl_registry_bind(registry, name, &wl_shm_interface, 1);
+    } else if (strcmp(interface, zwlr_layer_shell_v1_interface.name) == 0) {
+        self->m_layerShell = (struct zwlr_layer_shell_v1 *)wl_registry_bind(registry, name, &zwlr_layer_shell_v1_interface, 1);
+    } else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
+        self->m_viewporter = (struct wp_viewporter *)wl_registry_bind(registry, name, &wp_viewporter_interface, 1);
+    }
+}
+
+void SplashSurface::registryHandleGlobalRemove(void *data, struct wl_registry *registry, uint32_t name)
+{
+    (void)data;     // Unused parameter
+    (void)registry; // Unused parameter
+    (void)name;     // Unused parameter
+}
+
+void SplashSurface::layerSurfaceHandleConfigure(void *data, struct zwlr_layer_surface_v1 *surface, uint32_t serial, uint32_t width, uint32_t height)
+{
+    SplashSurface *self = static_cast<SplashSurface*>(data);
+    zwlr_layer_surface_v1_ack_configure(surface, serial);
+    self->m_width = width;
+    self->m_height = height;
+    self->m_configured = true;
+
+    // Output changed while the splash is up; rescale the same buffer
+    if (self->m_viewport && width > 0 && height > 0) {
+        wp_viewport_set_destination(self->m_viewport, width, height);
+        wl_surface_commit(self->m_wlSurface);
+    }
+}
+
+void SplashSurface::layerSurfaceHandleClosed(void *data, struct zwlr_layer_surface_v1 *surface)
+{
+    (void)data;    // Unused parameter
+    (void)surface; // Unused parameter
+    // Nothing to do; the greeter window replaces the splash anyway
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <memory>
+#include <wayland-client.h>
+#include "wlr-layer-shell-unstable-v1-client-protocol.h"
+#include "viewporter-client-protocol.h"
+
+class QQuickItem;
+class QSocketNotifier;
+
+/**
+ * @brief Shows the last rendered greeter background before Qt Quick is up.
+ *
+ * Uses its own Wayland connection and an overlay layer surface like
+ * LayerShell, but no Qt: the cache file is handed to the compositor as a
+ * wl_shm pool, so the pixels go from the page cache to the screen without
+ * being copied or decoded. Destroy the object once the Qt window has
+ * presented its first frame.
+ *
+ * The cache is a 64-byte header followed by opaque XRGB8888 pixels
+ * (QImage::Format_RGB32), rewritten by updateCache() after the greeter is up.
+ */
+class SplashSurface
+{
+public:
+    /**
+     * @brief Shows the splash if the cache exists and the compositor supports
+     * layer-shell. Needs no QGuiApplication; call startDispatch() once one
+     * exists.
+     */
+    explicit SplashSurface(const QString &cachePath);
+    ~SplashSurface();
+
+    bool isShown() const { return m_buffer != nullptr; }
+
+    // Services the splash's Wayland connection from the Qt event loop
+    void startDispatch();
+
+    /**
+     * @brief Reads the splash cache path from @p configPath, empty if the
+     * splash is disabled.
+     *
+     * Called before QGuiApplication exists, so it reads the setting itself
+     * instead of waiting for the rest of the configuration.
+     */
+    static QString cachePath(const QString &configPath);
+
+    // Key stored with the cached image, empty if there is none
+    static QByteArray cachedKey(const QString &cachePath);
+
+    /**
+     * @brief Renders @p background at its physical pixel size and stores it
+     * as the next splash, once its "ready" property is true. Nothing is
+     * rendered if the cache already holds the same @p sourceKey and size.
+     */
+    static void updateCache(QQuickItem *background, const QString &cachePath, const QByteArray &sourceKey);
+
+    // Wayland Static Callbacks (must be public for C callback access)
+    static void registryHandleGlobal(void *data, struct wl_registry *registry, uint32_t name, const char *interface, uint32_t version);
+    static void registryHandleGlobalRemove(void *data, struct wl_registry *registry, uint32_t name);
+    static void layerSurfaceHandleConfigure(void *data, struct zwlr_layer_surface_v1 *surface, uint32_t serial, uint32_t width, uint32_t height);
+    static void layerSurfaceHandleClosed(void *data, struct zwlr_layer_surface_v1 *surface);
+
+private:
+    bool show(const QString &cachePath);
+    // Events for the splash (configure, ping) while it is up
+    void dispatch();
+
+    struct wl_display *m_wlDisplay = nullptr;
+    std::unique_ptr<QSocketNotifier> m_notifier;
+    struct wl_registry *m_wlRegistry = nullptr;
+    struct wl_compositor *m_compositor = nullptr;
+    struct wl_shm *m_shm = nullptr;
+    struct zwlr_layer_shell_v1 *m_layerShell = nullptr;
+    struct wp_viewporter *m_viewporter = nullptr;
+
+    struct wl_surface *m_wlSurface = nullptr;
+    struct zwlr_layer_surface_v1 *m_layerSurface = nullptr;
+    struct wp_viewport *m_viewport = nullptr;
+    struct wl_shm_pool *m_pool = nullptr;
+    struct wl_buffer *m_buffer = nullptr;
+
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    bool m_configured = false;
+};
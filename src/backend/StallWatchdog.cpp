@@ -0,0 +1,166 @@
+#include "StallWatchdog.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QThread>
+#include <chrono>
+
+std::atomic<StallWatchdog *> StallWatchdog::s_instance { nullptr };
+
+namespace {
+constexpr int kHeartbeatMs = 50;
+constexpr int kCheckMs = 25;
+}
+
+StallWatchdog::Scope::Scope(const char *name)
+{
+    StallWatchdog *watchdog = s_instance.load();
+    if (!watchdog || QThread::currentThreadId() != watchdog->m_guiThread) {
+        return;
+    }
+    m_previous = watchdog->m_operation.exchange(name);
+    m_active = true;
+}
+
+StallWatchdog::Scope::~Scope()
+{
+    StallWatchdog *watchdog = s_instance.load();
+    if (m_active && watchdog) {
+        watchdog->m_operation.store(m_previous);
+    }
+}
+
+StallWatchdog::StallWatchdog(int thresholdMs, QObject *parent)
+    : QObject(parent)
+    , m_thresholdMs(thresholdMs)
+    , m_guiThread(QThread::currentThreadId())
+{
+    m_lastBeat.store(monotonicMs());
+
+    m_heartbeatTimer.setInterval(kHeartbeatMs);
+    connect(&m_heartbeatTimer, &QTimer::timeout, this, [this]() {
+        m_lastBeat.store(monotonicMs());
+    });
+    m_heartbeatTimer.start();
+
+    s_instance.store(this);
+    m_thread = std::thread(&StallWatchdog::run, this);
+
+    qInfo() << "StallWatchdog: Watching the GUI thread, threshold" << m_thresholdMs << "ms";
+}
+
+StallWatchdog::~StallWatchdog()
+{
+    s_instance.store(nullptr);
+    {
+        std::lock_guard<std::mutex> lock(m_stopMutex);
+        m_stop = true;
+    }
+    m_stopCondition.notify_all();
+    m_thread.join();
+
+    logSummary();
+}
+
+void StallWatchdog::logSummary()
+{
+    QMutexLocker locker(&m_statsMutex);
+    if (m_summaryLogged) {
+        return;
+    }
+    m_summaryLogged = true;
+
+    if (m_stats.isEmpty()) {
+        qInfo() << "StallWatchdog: No GUI-thread stalls over" << m_thresholdMs << "ms";
+        return;
+    }
+
+    qWarning() << "StallWatchdog: GUI-thread stalls over" << m_thresholdMs << "ms by operation:";
+    for (auto it = m_stats.cbegin(); it != m_stats.cend(); ++it) {
+        qWarning().nospace() << "  " << it.key().constData() << ": " << it->count << " stall(s), "
+                             << it->totalMs << " ms total, " << it->maxMs << " ms max";
+    }
+}
+
+void StallWatchdog::pause()
+{
+    m_heartbeatTimer.stop();
+    {
+        std::lock_guard<std::mutex> lock(m_stopMutex);
+        m_paused = true;
+    }
+    m_stopCondition.notify_all();
+}
+
+void StallWatchdog::resume()
+{
+    m_lastBeat.store(monotonicMs());
+    {
+        std::lock_guard<std::mutex> lock(m_stopMutex);
+        m_paused = false;
+    }
+    m_stopCondition.notify_all();
+    m_heartbeatTimer.start();
+}
+
+void StallWatchdog::run()
+{
+    qint64 stalledBeat = -1;
+    const char *stalledIn = nullptr;
+
+    std::unique_lock<std::mutex> lock(m_stopMutex);
+    while (true) {
+        // Sleeps without a timeout while paused
+        m_stopCondition.wait(lock, [this]() { return m_stop || !m_paused; });
+        if (m_stop) {
+            break;
+        }
+        if (m_stopCondition.wait_for(lock, std::chrono::milliseconds(kCheckMs), [this]() { return m_stop || m_paused; })) {
+            // A stall in progress is not measured across a pause
+            stalledBeat = -1;
+            stalledIn = nullptr;
+            continue;
+        }
+
+        const qint64 beat = m_lastBeat.load();
+
+        if (stalledBeat < 0) {
+            const qint64 late = monotonicMs() - beat - kHeartbeatMs;
+            if (late > m_thresholdMs) {
+                stalledBeat = beat;
+                stalledIn = m_operation.load();
+                qWarning() << "StallWatchdog: GUI thread blocked for more than" << m_thresholdMs << "ms in"
+                           << (stalledIn ? stalledIn : "(unattributed)");
+            }
+            continue;
+        }
+
+        if (!stalledIn) {
+            stalledIn = m_operation.load();
+        }
+
+        if (beat != stalledBeat) {
+            const qint64 duration = beat - stalledBeat - kHeartbeatMs;
+            recordStall(stalledIn, duration);
+            stalledBeat = -1;
+            stalledIn = nullptr;
+        }
+    }
+}
+
+void StallWatchdog::recordStall(const char *operation, qint64 durationMs)
+{
+    const QByteArray name = operation ? QByteArray(operation) : QByteArrayLiteral("(unattributed)");
+    qWarning() << "StallWatchdog: GUI thread was blocked for" << durationMs << "ms in" << name.constData();
+
+    QMutexLocker locker(&m_statsMutex);
+    StallStats &stats = m_stats[name];
+    ++stats.count;
+    stats.totalMs += durationMs;
+    stats.maxMs = qMax(stats.maxMs, durationMs);
+}
+
+qint64 StallWatchdog::monotonicMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief Detects GUI-thread stalls and attributes them to the instrumented
+ * blocking operation that was running at the time.
+ *
+ * The GUI thread bumps a heartbeat from a timer; a watchdog thread checks it
+ * and logs when it falls behind by more than the threshold. Blocking calls
+ * are marked with STALL_SCOPE("Class::operation"). A per-operation summary
+ * is logged at exit.
+ */
+class StallWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Marks a blocking GUI-thread operation for the lifetime of the guard.
+    // The name must be a string literal. No-op off the GUI thread.
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name);
+        ~Scope();
+
+    private:
+        const char *m_previous = nullptr;
+        bool m_active = false;
+    };
+
+    explicit StallWatchdog(int thresholdMs, QObject *parent = nullptr);
+    ~StallWatchdog() override;
+
+    // Logs the per-operation stall summary; also called from the destructor
+    void logSummary();
+
+    // Stops the heartbeat and the watchdog thread's polling, e.g. while the
+    // outputs are off; resume() starts both again
+    void pause();
+    void resume();
+
+private:
+    struct StallStats {
+        int count = 0;
+        qint64 totalMs = 0;
+        qint64 maxMs = 0;
+    };
+
+    void run();
+    void recordStall(const char *operation, qint64 durationMs);
+    static qint64 monotonicMs();
+
+    static std::atomic<StallWatchdog *> s_instance;
+
+    const int m_thresholdMs;
+    QTimer m_heartbeatTimer;
+    std::thread m_thread;
+    std::mutex m_stopMutex;
+    std::condition_variable m_stopCondition;
+    bool m_stop = false;
+    bool m_paused = false;
+    bool m_summaryLogged = false;
+
+    std::atomic<qint64> m_lastBeat { 0 };
+    std::atomic<const char *> m_operation { nullptr };
+    Qt::HANDLE m_guiThread = nullptr;
+
+    QMutex m_statsMutex;
+    QMap<QByteArray, StallStats> m_stats;
+};
+
+#define STALL_SCOPE_CONCAT_(a, b) a##b
+#define STALL_SCOPE_NAME_(line) STALL_SCOPE_CONCAT_(stallScope_, line)
+#define STALL_SCOPE(name) StallWatchdog::Scope STALL_SCOPE_NAME_(__LINE__)(name)
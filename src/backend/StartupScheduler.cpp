@@ -0,0 +1,129 @@
+#include "StartupScheduler.h"
+#include <QDebug>
+#include <QMetaEnum>
+#include <QQuickWindow>
+
+StartupScheduler *StartupScheduler::s_instance = nullptr;
+
+namespace {
+// Start the deferred queues even if the compositor never presents a frame
+constexpr int kFirstFrameFallbackMs = 3000;
+// Gap between idle tasks so they never bunch up in front of input events
+constexpr int kIdleGapMs = 50;
+}
+
+StartupScheduler::StartupScheduler(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+    s_instance = this;
+
+    m_fallbackTimer.setSingleShot(true);
+    m_fallbackTimer.setInterval(kFirstFrameFallbackMs);
+    connect(&m_fallbackTimer, &QTimer::timeout, this, [this]() {
+        qWarning() << "StartupScheduler: No frame after" << kFirstFrameFallbackMs << "ms, running deferred tasks anyway";
+        onFirstFrame();
+    });
+}
+
+StartupScheduler::~StartupScheduler()
+{
+    if (s_instance == this) {
+        s_instance = nullptr;
+    }
+}
+
+void StartupScheduler::attachWindow(QQuickWindow *window)
+{
+    if (!window) {
+        onFirstFrame();
+        return;
+    }
+
+    m_frameConnection = connect(window, &QQuickWindow::frameSwapped, this, &StartupScheduler::onFirstFrame,
+            Qt::QueuedConnection);
+    m_fallbackTimer.start();
+}
+
+void StartupScheduler::schedule(Priority priority, const QString &name, QObject *context, std::function<void()> task)
+{
+    if (!s_instance) {
+        task();
+        return;
+    }
+    if (priority == Critical) {
+        s_instance->runTask(Critical, { name, context, std::move(task) });
+        return;
+    }
+
+    s_instance->enqueue(priority, { name, context, std::move(task) });
+}
+
+bool StartupScheduler::firstFrameShown()
+{
+    return !s_instance || s_instance->m_firstFrame;
+}
+
+void StartupScheduler::enqueue(Priority priority, Task task)
+{
+    if (priority == PostFirstFrame) {
+        m_postFirstFrame.append(std::move(task));
+    } else {
+        m_idle.append(std::move(task));
+    }
+
+    if (m_firstFrame && !m_running) {
+        m_running = true;
+        QTimer::singleShot(0, this, &StartupScheduler::runNext);
+    }
+}
+
+void StartupScheduler::onFirstFrame()
+{
+    if (m_firstFrame) {
+        return;
+    }
+    m_firstFrame = true;
+    m_fallbackTimer.stop();
+    disconnect(m_frameConnection);
+
+    qInfo() << "StartupScheduler: First frame after" << m_clock.elapsed() << "ms,"
+            << m_postFirstFrame.count() << "post-first-frame and" << m_idle.count() << "idle task(s) queued";
+    emit firstFrameSwapped();
+
+    if (!m_running) {
+        m_running = true;
+        QTimer::singleShot(0, this, &StartupScheduler::runNext);
+    }
+}
+
+void StartupScheduler::runNext()
+{
+    if (!m_postFirstFrame.isEmpty()) {
+        runTask(PostFirstFrame, m_postFirstFrame.takeFirst());
+    } else if (!m_idle.isEmpty()) {
+        runTask(Idle, m_idle.takeFirst());
+    }
+
+    if (!m_postFirstFrame.isEmpty()) {
+        QTimer::singleShot(0, this, &StartupScheduler::runNext);
+    } else if (!m_idle.isEmpty()) {
+        QTimer::singleShot(kIdleGapMs, this, &StartupScheduler::runNext);
+    } else {
+        m_running = false;
+    }
+}
+
+void StartupScheduler::runTask(Priority priority, const Task &task)
+{
+    if (!task.context) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    task.run();
+    qDebug() << "StartupScheduler:" << task.name << "("
+             << QMetaEnum::fromType<Priority>().valueToKey(priority) << ") took"
+             << timer.elapsed() << "ms, done at" << m_clock.elapsed() << "ms";
+}
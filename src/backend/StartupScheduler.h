@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QTimer>
+#include <functional>
+
+class QQuickWindow;
+
+/**
+ * @brief Orders expensive backend initialisation around the first frame.
+ *
+ * Critical work runs immediately, PostFirstFrame work runs once the first
+ * frame was swapped (one task per event loop iteration so input stays
+ * responsive) and Idle work runs after that queue has drained.
+ * Without a scheduler instance every task runs immediately.
+ */
+class StartupScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        Critical,
+        PostFirstFrame,
+        Idle
+    };
+    Q_ENUM(Priority)
+
+    explicit StartupScheduler(QObject *parent = nullptr);
+    ~StartupScheduler() override;
+
+    /**
+     * @brief Starts the deferred queues after the window's first frame, or
+     * after a fallback timeout if no frame arrives.
+     */
+    void attachWindow(QQuickWindow *window);
+
+    /**
+     * @brief Queues a named task. It is dropped if @p context is destroyed
+     * before it runs.
+     */
+    static void schedule(Priority priority, const QString &name, QObject *context, std::function<void()> task);
+
+    static bool firstFrameShown();
+
+signals:
+    void firstFrameSwapped();
+
+private:
+    struct Task {
+        QString name;
+        QPointer<QObject> context;
+        std::function<void()> run;
+    };
+
+    void enqueue(Priority priority, Task task);
+    void onFirstFrame();
+    void runNext();
+    void runTask(Priority priority, const Task &task);
+
+    static StartupScheduler *s_instance;
+
+    QElapsedTimer m_clock;
+    QTimer m_fallbackTimer;
+    QMetaObject::Connection m_frameConnection;
+    QList<Task> m_postFirstFrame;
+    QList<Task> m_idle;
+    bool m_firstFrame = false;
+    bool m_running = false;
+};
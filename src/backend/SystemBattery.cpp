@@ -1,4 +1,7 @@
 #include "SystemBattery.h"
+#include "StartupScheduler.h"
+#include "StallWatchdog.h"
+#include "Instrumentation.h"
 #include <QDir>
 #include <QFile>
 #include <QDebug>
@@ -6,9 +9,27 @@
 SystemBattery::SystemBattery(QObject *parent) : QObject(parent)
 {
     m_timer = new QTimer(this);
+    m_timer->setInterval(10000); // Check every 10 seconds
     connect(m_timer, &QTimer::timeout, this, &SystemBattery::refresh);
-    m_timer->start(10000); // Check every 10 seconds
-    refresh();
+
+    // sysfs is walked after the first frame; the indicator stays hidden until then
+    StartupScheduler::schedule(StartupScheduler::PostFirstFrame, QStringLiteral("battery"), this, [this]() {
+        m_started = true;
+        refresh();
+        if (!m_paused) {
+            m_timer->start();
+        }
+    });
+}
+
+QStringList SystemBattery::iconNames()
+{
+    QStringList names;
+    for (const char *level : { "caution", "low", "good", "full" }) {
+        names << QStringLiteral("battery-%1").arg(QLatin1String(level))
+              << QStringLiteral("battery-%1-charging").arg(QLatin1String(level));
+    }
+    return names;
 }
 
 void SystemBattery::setDebugBattery(bool debugBattery)
@@ -24,6 +45,25 @@ void SystemBattery::setDebugBattery(bool debugBattery)
     refresh();
 }
 
+void SystemBattery::setPaused(bool paused)
+{
+    if (m_paused == paused) {
+        return;
+    }
+
+    m_paused = paused;
+    if (m_started) {
+        if (m_paused) {
+            m_timer->stop();
+        } else {
+            // The charge moved on while nobody was looking
+            refresh();
+            m_timer->start();
+        }
+    }
+    emit pausedChanged();
+}
+
 void SystemBattery::refresh()
 {
     if (m_debugBattery) {
@@ -53,6 +93,9 @@ void SystemBattery::refresh()
         return;
     }
 
+    // Battery attributes are read from the embedded controller and can be slow
+    STALL_SCOPE("SystemBattery::refresh");
+    LATENCY_SCOPE("sysfs.battery");
     QString batteryPath;
     QDir dir("/sys/class/power_supply");
     
@@ -1,6 +1,7 @@
 #pragma once
 #include <QObject>
 #include <QTimer>
+#include <QStringList>
 
 class SystemBattery : public QObject
 {
@@ -9,6 +10,8 @@ class SystemBattery : public QObject
     Q_PROPERTY(QString iconName READ iconName NOTIFY infoChanged)
     Q_PROPERTY(bool available READ available NOTIFY availableChanged)
     Q_PROPERTY(bool debugBattery READ debugBattery WRITE setDebugBattery NOTIFY debugBatteryChanged)
+    // Stops polling sysfs, e.g. while the outputs are off
+    Q_PROPERTY(bool paused READ paused WRITE setPaused NOTIFY pausedChanged)
 
 public:
     explicit SystemBattery(QObject *parent = nullptr);
@@ -18,11 +21,17 @@ public:
     bool available() const { return m_available; }
     bool debugBattery() const { return m_debugBattery; }
     void setDebugBattery(bool debugBattery);
+    bool paused() const { return m_paused; }
+    void setPaused(bool paused);
+
+    // Every icon name iconName can take, for warming the icon cache
+    static QStringList iconNames();
 
 signals:
     void infoChanged();
     void availableChanged();
     void debugBatteryChanged();
+    void pausedChanged();
 
 private slots:
     void refresh();
@@ -33,5 +42,7 @@ private:
     QString m_iconName = QStringLiteral("battery-full");
     bool m_available = false;
     bool m_debugBattery = false;
+    bool m_paused = false;
+    bool m_started = false;
     int m_debugState = 0;
 };
@@ -1,12 +1,26 @@
 #include "SystemPower.h"
+#include "StartupScheduler.h"
+#include "StallWatchdog.h"
+#include "Instrumentation.h"
 #include <QDBusInterface>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QDBusReply>
 #include <QDebug>
 
-SystemPower::SystemPower(QObject *parent) : QObject(parent) {}
+SystemPower::SystemPower(QObject *parent) : QObject(parent)
+{
+    // The power buttons are filled in right after the first frame
+    StartupScheduler::schedule(StartupScheduler::PostFirstFrame, QStringLiteral("power-capabilities"), this, [this]() {
+        refreshCapabilities();
+    });
+}
 
 void SystemPower::powerOff()
 {
+    STALL_SCOPE("SystemPower::PowerOff");
+    LATENCY_SCOPE("logind.PowerOff");
     QDBusInterface interface("org.freedesktop.login1", 
                              "/org/freedesktop/login1",
                              "org.freedesktop.login1.Manager", 
@@ -18,6 +32,8 @@ void SystemPower::powerOff()
 
 void SystemPower::reboot()
 {
+    STALL_SCOPE("SystemPower::Reboot");
+    LATENCY_SCOPE("logind.Reboot");
     QDBusInterface interface("org.freedesktop.login1", 
                              "/org/freedesktop/login1",
                              "org.freedesktop.login1.Manager", 
@@ -27,6 +43,8 @@ void SystemPower::reboot()
 
 void SystemPower::suspend()
 {
+    STALL_SCOPE("SystemPower::Suspend");
+    LATENCY_SCOPE("logind.Suspend");
     QDBusInterface interface("org.freedesktop.login1", 
                              "/org/freedesktop/login1",
                              "org.freedesktop.login1.Manager", 
@@ -36,6 +54,8 @@ void SystemPower::suspend()
 
 void SystemPower::hibernate()
 {
+    STALL_SCOPE("SystemPower::Hibernate");
+    LATENCY_SCOPE("logind.Hibernate");
     QDBusInterface interface("org.freedesktop.login1",
                              "/org/freedesktop/login1",
                              "org.freedesktop.login1.Manager",
@@ -45,6 +65,8 @@ void SystemPower::hibernate()
 
 void SystemPower::hybridSleep()
 {
+    STALL_SCOPE("SystemPower::HybridSleep");
+    LATENCY_SCOPE("logind.HybridSleep");
     QDBusInterface interface("org.freedesktop.login1",
                              "/org/freedesktop/login1",
                              "org.freedesktop.login1.Manager",
@@ -54,6 +76,8 @@ void SystemPower::hybridSleep()
 
 void SystemPower::suspendThenHibernate()
 {
+    STALL_SCOPE("SystemPower::SuspendThenHibernate");
+    LATENCY_SCOPE("logind.SuspendThenHibernate");
     QDBusInterface interface("org.freedesktop.login1",
                              "/org/freedesktop/login1",
                              "org.freedesktop.login1.Manager",
@@ -61,62 +85,38 @@ void SystemPower::suspendThenHibernate()
     interface.call("SuspendThenHibernate", true);
 }
 
-bool SystemPower::canPowerOff()
-{
-    QDBusInterface interface("org.freedesktop.login1",
-                             "/org/freedesktop/login1",
-                             "org.freedesktop.login1.Manager",
-                             QDBusConnection::systemBus());
-    QDBusReply<QString> reply = interface.call("CanPowerOff");
-    return reply.isValid() && (reply.value() == "yes");
-}
-
-bool SystemPower::canReboot()
+void SystemPower::refreshCapabilities()
 {
-    QDBusInterface interface("org.freedesktop.login1",
-                             "/org/freedesktop/login1",
-                             "org.freedesktop.login1.Manager",
-                             QDBusConnection::systemBus());
-    QDBusReply<QString> reply = interface.call("CanReboot");
-    return reply.isValid() && (reply.value() == "yes");
-}
-
-bool SystemPower::canSuspend()
-{
-    QDBusInterface interface("org.freedesktop.login1",
-                             "/org/freedesktop/login1",
-                             "org.freedesktop.login1.Manager",
-                             QDBusConnection::systemBus());
-    QDBusReply<QString> reply = interface.call("CanSuspend");
-    return reply.isValid() && (reply.value() == "yes");
+    queryCapability(QStringLiteral("CanPowerOff"), &SystemPower::m_canPowerOff);
+    queryCapability(QStringLiteral("CanReboot"), &SystemPower::m_canReboot);
+    queryCapability(QStringLiteral("CanSuspend"), &SystemPower::m_canSuspend);
+    queryCapability(QStringLiteral("CanHibernate"), &SystemPower::m_canHibernate);
+    queryCapability(QStringLiteral("CanHybridSleep"), &SystemPower::m_canHybridSleep);
+    queryCapability(QStringLiteral("CanSuspendThenHibernate"), &SystemPower::m_canSuspendThenHibernate);
 }
 
-bool SystemPower::canHibernate()
+void SystemPower::queryCapability(const QString &method, bool SystemPower::*member)
 {
-    QDBusInterface interface("org.freedesktop.login1",
-                             "/org/freedesktop/login1",
-                             "org.freedesktop.login1.Manager",
-                             QDBusConnection::systemBus());
-    QDBusReply<QString> reply = interface.call("CanHibernate");
-    return reply.isValid() && (reply.value() == "yes");
-}
+    // A plain message avoids QDBusInterface's blocking introspection
+    const QDBusMessage message = QDBusMessage::createMethodCall("org.freedesktop.login1",
+                                                                "/org/freedesktop/login1",
+                                                                "org.freedesktop.login1.Manager",
+                                                                method);
+    const qint64 sentAt = Instrumentation::enabled() ? Instrumentation::nowNs() : 0;
+    auto *watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, method, member, sentAt]() {
+        watcher->deleteLater();
+        Instrumentation::record("logind." + method.toLatin1(), sentAt);
 
-bool SystemPower::canHybridSleep()
-{
-    QDBusInterface interface("org.freedesktop.login1",
-                             "/org/freedesktop/login1",
-                             "org.freedesktop.login1.Manager",
-                             QDBusConnection::systemBus());
-    QDBusReply<QString> reply = interface.call("CanHybridSleep");
-    return reply.isValid() && (reply.value() == "yes");
-}
+        const QDBusPendingReply<QString> reply = *watcher;
+        if (reply.isError()) {
+            qWarning() << "SystemPower:" << method << "failed:" << reply.error().message();
+        }
 
-bool SystemPower::canSuspendThenHibernate()
-{
-    QDBusInterface interface("org.freedesktop.login1",
-                             "/org/freedesktop/login1",
-                             "org.freedesktop.login1.Manager",
-                             QDBusConnection::systemBus());
-    QDBusReply<QString> reply = interface.call("CanSuspendThenHibernate");
-    return reply.isValid() && (reply.value() == "yes");
+        const bool available = reply.isValid() && reply.value() == "yes";
+        if (this->*member != available) {
+            this->*member = available;
+            emit capabilitiesChanged();
+        }
+    });
 }
@@ -4,6 +4,12 @@
 class SystemPower : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(bool canPowerOff READ canPowerOff NOTIFY capabilitiesChanged)
+    Q_PROPERTY(bool canReboot READ canReboot NOTIFY capabilitiesChanged)
+    Q_PROPERTY(bool canSuspend READ canSuspend NOTIFY capabilitiesChanged)
+    Q_PROPERTY(bool canHibernate READ canHibernate NOTIFY capabilitiesChanged)
+    Q_PROPERTY(bool canHybridSleep READ canHybridSleep NOTIFY capabilitiesChanged)
+    Q_PROPERTY(bool canSuspendThenHibernate READ canSuspendThenHibernate NOTIFY capabilitiesChanged)
 public:
     explicit SystemPower(QObject *parent = nullptr);
 
@@ -14,11 +20,27 @@ public:
     Q_INVOKABLE void hybridSleep();
     Q_INVOKABLE void suspendThenHibernate();
 
-    // Check if actions are available
-    Q_INVOKABLE bool canPowerOff();
-    Q_INVOKABLE bool canReboot();
-    Q_INVOKABLE bool canSuspend();
-    Q_INVOKABLE bool canHibernate();
-    Q_INVOKABLE bool canHybridSleep();
-    Q_INVOKABLE bool canSuspendThenHibernate();
+    // Cached logind capabilities; all false until the first query answers
+    bool canPowerOff() const { return m_canPowerOff; }
+    bool canReboot() const { return m_canReboot; }
+    bool canSuspend() const { return m_canSuspend; }
+    bool canHibernate() const { return m_canHibernate; }
+    bool canHybridSleep() const { return m_canHybridSleep; }
+    bool canSuspendThenHibernate() const { return m_canSuspendThenHibernate; }
+
+    // Re-query logind asynchronously
+    Q_INVOKABLE void refreshCapabilities();
+
+signals:
+    void capabilitiesChanged();
+
+private:
+    void queryCapability(const QString &method, bool SystemPower::*member);
+
+    bool m_canPowerOff = false;
+    bool m_canReboot = false;
+    bool m_canSuspend = false;
+    bool m_canHibernate = false;
+    bool m_canHybridSleep = false;
+    bool m_canSuspendThenHibernate = false;
 };
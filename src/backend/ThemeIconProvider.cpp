@@ -0,0 +1,52 @@
+#include "ThemeIconProvider.h"
+#include "IconCache.h"
+#include "Instrumentation.h"
+#include "Readahead.h"
+#include <QDebug>
+#include <QImageReader>
+#include <QMutexLocker>
+
+ThemeIconProvider::ThemeIconProvider(IconCache *cache)
+    : QQuickImageProvider(QQuickImageProvider::Image)
+    , m_cache(cache)
+{
+}
+
+QImage ThemeIconProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    const int extent = requestedSize.isValid()
+        ? qMax(requestedSize.width(), requestedSize.height()) : 48;
+    const QString key = QStringLiteral("%1@%2").arg(id).arg(extent);
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_images.constFind(key);
+    if (it == m_images.constEnd()) {
+        QImage image;
+        const QString path = m_cache->lookup(id, extent);
+        if (path.isEmpty()) {
+            qWarning() << "ThemeIconProvider: No icon named" << id;
+        } else {
+            LATENCY_SCOPE("image.decode");
+            Readahead::note(path);
+            QImageReader reader(path);
+            reader.setScaledSize(QSize(extent, extent));
+            image = reader.read();
+        }
+        it = m_images.insert(key, image);
+    }
+
+    if (size) {
+        *size = it->size();
+    }
+    return *it;
+}
+
+qint64 ThemeIconProvider::cacheBytes()
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 bytes = 0;
+    for (const QImage &image : std::as_const(m_images)) {
+        bytes += image.sizeInBytes();
+    }
+    return bytes;
+}
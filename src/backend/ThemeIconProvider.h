@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QQuickImageProvider>
+
+class IconCache;
+
+/**
+ * @brief Serves theme icons by name through the precomputed IconCache.
+ * Request as "image://themeicon/<name>" with a sourceSize (or icon size) set.
+ * Rasterised icons are kept, so battery state changes never hit the disk.
+ */
+class ThemeIconProvider : public QQuickImageProvider
+{
+public:
+    explicit ThemeIconProvider(IconCache *cache);
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+
+    // Bytes held by rasterised icons
+    qint64 cacheBytes();
+
+private:
+    IconCache *m_cache;
+    QMutex m_mutex;
+    QHash<QString, QImage> m_images;
+};
@@ -0,0 +1,126 @@
+#include "ThreadPriority.h"
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <QDebug>
+#include <QThreadPool>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// linux/ioprio.h is not shipped by every libc
+constexpr int kIoprioWhoProcess = 1;
+constexpr int kIoprioClassShift = 13;
+constexpr int kIoprioClassBestEffort = 2;
+constexpr int kIoprioClassIdle = 3;
+
+struct Policy {
+    const char *name;
+    int schedPolicy;
+    int nice;
+    int ioClass;   // 0 leaves the I/O priority alone
+    int ioLevel;
+};
+
+const Policy kNormal = { "normal", SCHED_OTHER, 0, 0, 0 };
+const Policy kLow = { "low", SCHED_OTHER, 10, kIoprioClassBestEffort, 7 };
+const Policy kIdle = { "idle", SCHED_IDLE, 19, kIoprioClassIdle, 0 };
+
+Policy s_policies[] = { kNormal, kLow, kIdle };
+
+thread_local int t_class = ThreadPriority::Critical;
+
+Policy parsePolicy(const QString &value, const Policy &fallback)
+{
+    const QString normalized = value.trimmed().toLower();
+    for (const Policy &policy : { kNormal, kLow, kIdle }) {
+        if (normalized == QLatin1String(policy.name)) {
+            return policy;
+        }
+    }
+    if (!normalized.isEmpty()) {
+        qWarning() << "ThreadPriority: Unknown priority" << value << ", using" << fallback.name;
+    }
+    return fallback;
+}
+
+QString describe(const Policy &policy)
+{
+    if (policy.ioClass == 0) {
+        return QLatin1String(policy.name);
+    }
+    return QStringLiteral("%1 (%2, nice %3, io %4)")
+        .arg(QLatin1String(policy.name))
+        .arg(policy.schedPolicy == SCHED_IDLE ? QStringLiteral("SCHED_IDLE") : QStringLiteral("SCHED_OTHER"))
+        .arg(policy.nice)
+        .arg(policy.ioClass == kIoprioClassIdle ? QStringLiteral("idle")
+                                                : QStringLiteral("best-effort/%1").arg(policy.ioLevel));
+}
+
+} // namespace
+
+void ThreadPriority::configure(const QString &background, const QString &maintenance)
+{
+    s_policies[Background] = parsePolicy(background, kLow);
+    s_policies[Maintenance] = parsePolicy(maintenance, kIdle);
+
+    errno = 0;
+    const int guiNice = getpriority(PRIO_PROCESS, 0);
+    qInfo().noquote() << "ThreadPriority: GUI thread" << (errno == 0 ? QStringLiteral("nice %1").arg(guiNice) : QStringLiteral("nice unknown"))
+                      << "| critical:" << describe(s_policies[Critical])
+                      << "| background:" << describe(s_policies[Background])
+                      << "| maintenance:" << describe(s_policies[Maintenance]);
+}
+
+void ThreadPriority::enter(Class cls)
+{
+    if (t_class == cls) {
+        return;
+    }
+    t_class = cls;
+
+    // All of these are per thread on Linux, addressed by thread id
+    const Policy &policy = s_policies[cls];
+    const pid_t tid = pid_t(syscall(SYS_gettid));
+
+    struct sched_param param = {};
+    if (sched_setscheduler(0, policy.schedPolicy, &param) != 0) {
+        qWarning() << "ThreadPriority: sched_setscheduler failed:" << strerror(errno);
+    }
+    // Lowering is always allowed; raising back is not, which is why
+    // classes get their own pools
+    if (setpriority(PRIO_PROCESS, id_t(tid), policy.nice) != 0) {
+        qDebug() << "ThreadPriority: setpriority" << policy.nice << "failed:" << strerror(errno);
+    }
+    if (policy.ioClass != 0
+        && syscall(SYS_ioprio_set, kIoprioWhoProcess, tid, (policy.ioClass << kIoprioClassShift) | policy.ioLevel) != 0) {
+        qWarning() << "ThreadPriority: ioprio_set failed:" << strerror(errno);
+    }
+}
+
+QThreadPool *ThreadPriority::pool(Class cls)
+{
+    // Never freed, like the global pool they sit next to
+    static QThreadPool *background = []() {
+        auto *pool = new QThreadPool;
+        pool->setMaxThreadCount(2);
+        return pool;
+    }();
+    static QThreadPool *maintenance = []() {
+        auto *pool = new QThreadPool;
+        pool->setMaxThreadCount(1);
+        return pool;
+    }();
+
+    switch (cls) {
+    case Background:
+        return background;
+    case Maintenance:
+        return maintenance;
+    case Critical:
+        break;
+    }
+    return QThreadPool::globalInstance();
+}
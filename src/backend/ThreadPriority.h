@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QString>
+#include <QtConcurrent/QtConcurrentRun>
+
+class QThreadPool;
+
+/**
+ * @brief CPU and I/O scheduling classes for the greeter's worker threads.
+ *
+ * The greeter starts while the rest of boot still competes for CPU and disk.
+ * Work needed for the first frame runs at normal priority, everything else
+ * steps aside:
+ *
+ *   Critical     visible images (wallpaper, shown avatar): untouched
+ *   Background   home probes, user reloads, prefetch, next slide
+ *   Maintenance  cache pruning and rewrites
+ *
+ * Each class has its own thread pool, so a lowered thread never picks up
+ * critical work. The GUI and render threads are never changed.
+ */
+class ThreadPriority
+{
+public:
+    enum Class {
+        Critical,
+        Background,
+        Maintenance
+    };
+
+    /**
+     * @brief Sets the policy of the two lowered classes and logs it.
+     * @param background, maintenance "normal", "low" (nice 10, best-effort
+     * I/O at the lowest level) or "idle" (SCHED_IDLE, idle I/O class)
+     */
+    static void configure(const QString &background, const QString &maintenance);
+
+    // Moves the calling thread into a class; cheap when it already is there
+    static void enter(Class cls);
+
+    // Critical is Qt's global pool
+    static QThreadPool *pool(Class cls);
+
+    // QtConcurrent::run on the class's pool, with the class entered first
+    template <typename Function>
+    static auto run(Class cls, Function function)
+    {
+        return QtConcurrent::run(pool(cls), [cls, function]() mutable {
+            enter(cls);
+            return function();
+        });
+    }
+};
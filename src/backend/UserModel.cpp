@@ -1,7 +1,70 @@
 #include "UserModel.h"
-#include <pwd.h>
+#include "Instrumentation.h"
+#include "StartupScheduler.h"
+#include "ThreadPriority.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <QDebug>
+#include <QFile>
+#include <QDateTime>
 #include <QFileInfo>
 #include <QImageReader>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <chrono>
+
+#ifndef STATX_ATTR_AUTOMOUNT
+#define STATX_ATTR_AUTOMOUNT 0x00001000
+#endif
+
+namespace {
+
+// Where accounts and their icons come from; watched while the greeter is up
+const char kPasswdFile[] = "/etc/passwd";
+const char kAccountsUsersDir[] = "/var/lib/AccountsService/users";
+const char kAccountsIconsDir[] = "/var/lib/AccountsService/icons";
+
+// Tools like useradd touch several files in a row
+constexpr int kReloadDelayMs = 500;
+
+// Filesystems where a stat or open can block on the network
+struct RemoteFs {
+    unsigned long magic;
+    const char *name;
+};
+
+const RemoteFs kRemoteFilesystems[] = {
+    { 0x6969, "nfs" },
+    { 0x517B, "smb" },
+    { 0xFF534D42, "cifs" },
+    { 0xFE534D42, "smb2" },
+    { 0x5346414F, "afs" },
+    { 0x00C36400, "ceph" },
+    { 0x73757245, "coda" },
+    { 0x65735546, "fuse" },
+    { 0x0187, "autofs" },
+};
+
+const char *remoteFilesystemName(unsigned long magic)
+{
+    for (const RemoteFs &fs : kRemoteFilesystems) {
+        if (fs.magic == magic) {
+            return fs.name;
+        }
+    }
+    return nullptr;
+}
+
+// stat() that never triggers an automount of the last path component
+bool statNoAutomount(const QString &path, struct statx *stx)
+{
+    const QByteArray nativePath = QFile::encodeName(path);
+    return statx(AT_FDCWD, nativePath.constData(), AT_NO_AUTOMOUNT,
+                 STATX_TYPE | STATX_MODE, stx) == 0;
+}
+
+} // namespace
 
 UserModel::UserModel(QObject *parent)
     : UserModel(QString(), parent)
@@ -9,52 +72,394 @@ UserModel::UserModel(QObject *parent)
 }
 
 UserModel::UserModel(const QString &avatarOverridePattern, QObject *parent)
+    : UserModel(avatarOverridePattern, AvatarProbeOptions(), QStringLiteral("auto"), parent)
+{
+}
+
+UserModel::UserModel(const QString &avatarOverridePattern, const AvatarProbeOptions &probeOptions,
+                     const QString &userSource, QObject *parent)
     : QAbstractListModel(parent)
     , m_avatarOverridePattern(avatarOverridePattern.trimmed())
+    , m_probeOptions(probeOptions)
+    , m_source(UserSource::create(userSource))
+    , m_probePool(new QThreadPool)
 {
-    loadUsers();
+    m_probePool->setMaxThreadCount(qMax(1, m_probeOptions.concurrency));
+
+    m_deadlineTimer.setInterval(100);
+    connect(&m_deadlineTimer, &QTimer::timeout, this, &UserModel::checkProbeDeadlines);
+
+    m_reloadTimer.setSingleShot(true);
+    m_reloadTimer.setInterval(kReloadDelayMs);
+    connect(&m_reloadTimer, &QTimer::timeout, this, &UserModel::reloadUsers);
+    connect(&m_sourceWatcher, &QFileSystemWatcher::fileChanged, this, [this](const QString &path) {
+        // Replaced by rename (useradd, vipw); the watch went with the old inode
+        if (!m_sourceWatcher.files().contains(path) && QFileInfo::exists(path)) {
+            m_sourceWatcher.addPath(path);
+        }
+        scheduleReload(false);
+    });
+    connect(&m_sourceWatcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString &path) {
+        scheduleReload(path != QLatin1String(kAccountsUsersDir));
+    });
+
+    // The selected user is part of the first frame; the lookup itself runs
+    // on a worker and the list fills in when it is done
+    StartupScheduler::schedule(StartupScheduler::Critical, QStringLiteral("users"), this, [this]() {
+        loadUsers();
+    });
+}
+
+UserModel::~UserModel()
+{
+    m_deadlineTimer.stop();
+    m_reloadTimer.stop();
+    if (m_reloadWatcher) {
+        // The reload uses m_source
+        m_reloadWatcher->waitForFinished();
+    }
+    m_probePool->clear();
+
+    int running = 0;
+    for (const AvatarProbe &probe : std::as_const(m_probes)) {
+        if (probe.startedAt->load() >= 0) {
+            ++running;
+        }
+    }
+
+    // A probe stuck on a hung network filesystem cannot be interrupted.
+    // Waiting for it here would hang the greeter on exit, so the pool is
+    // deliberately leaked in that case.
+    if (running > 0) {
+        qWarning() << "UserModel: Leaving" << running << "unfinished avatar probe(s) behind";
+        return;
+    }
+    delete m_probePool;
 }
 
 void UserModel::loadUsers() {
+    // Every source may block: NSS can go to LDAP/SSSD, userdb and
+    // AccountsService are IPC round trips with a timeout each
+    m_reloadWatcher = new QFutureWatcher<Snapshot>(this);
+    connect(m_reloadWatcher, &QFutureWatcher<Snapshot>::finished, this, [this]() {
+        const Snapshot snapshot = m_reloadWatcher->result();
+        m_reloadWatcher->deleteLater();
+        m_reloadWatcher = nullptr;
+        finishLoad(snapshot);
+    });
+
+    UserSource *source = m_source.get();
+    m_reloadWatcher->setFuture(ThreadPriority::run(ThreadPriority::Critical, [source]() {
+        LATENCY_SCOPE("model.users");
+        Snapshot snapshot;
+        snapshot.users = source->users();
+        if (!snapshot.users) {
+            snapshot.fellBack = true;
+            snapshot.users = UserSource::create(QStringLiteral("passwd"))->users();
+        }
+        if (snapshot.users) {
+            resolveIcons(&*snapshot.users, &snapshot.iconStamps);
+        }
+        return snapshot;
+    }));
+}
+
+void UserModel::finishLoad(const Snapshot &snapshot) {
+    if (snapshot.fellBack) {
+        qWarning() << "UserModel: User source" << m_source->name() << "unavailable, falling back to passwd";
+        m_source = UserSource::create(QStringLiteral("passwd"));
+    }
+
     beginResetModel();
-    m_users.clear();
+    m_users = snapshot.users.value_or(QVector<User>());
+    m_iconStamps = snapshot.iconStamps;
+    for (const User &user : std::as_const(m_users)) {
+        m_baseIcons.insert(user.username, user.iconPath);
+    }
+    endResetModel();
+    qInfo() << "UserModel: Loaded" << m_users.count() << "user(s) from" << m_source->name();
 
-    struct passwd *pwent;
-    setpwent();
-    while ((pwent = getpwent()) != nullptr) {
-        const int uid = pwent->pw_uid;
+    startAvatarProbes();
 
-        if (uid >= 1000 && uid < 60000) {
-            const QString name = pwent->pw_name;
-            const QString gecos = QString::fromUtf8(pwent->pw_gecos).split(",").first();
-            const QString home = pwent->pw_dir;
-            const QString icon = findUserAvatar(name, home);
+    // Only the first load resets the model; later changes arrive as diffs
+    StartupScheduler::schedule(StartupScheduler::Idle, QStringLiteral("users-watch"), this, [this]() {
+        watchSources();
+    });
+}
 
-            m_users.append({name, gecos.isEmpty() ? name : gecos, icon});
+void UserModel::resolveIcons(QVector<User> *users, QHash<QString, qint64> *iconStamps) {
+    for (User &user : *users) {
+        // Home directories are probed asynchronously; start with what is
+        // available locally and upgrade the icon when the probe finishes.
+        if (!isUsableAvatarFile(user.iconPath)) {
+            user.iconPath = findLocalAvatar(user.username);
         }
+        iconStamps->insert(user.username, iconStamp(user.iconPath));
     }
-    endpwent();
+}
 
-    endResetModel();
+qint64 UserModel::iconStamp(const QString &path) {
+    if (path.startsWith("qrc:")) {
+        return 0;
+    }
+    return QFileInfo(path).lastModified().toMSecsSinceEpoch();
 }
 
-QString UserModel::findUserAvatar(const QString &username, const QString &homeDir) const {
-    const QString configuredAvatar = resolveAvatarOverride(username, homeDir);
-    if (isUsableAvatarFile(configuredAvatar)) {
-        return configuredAvatar;
+void UserModel::watchSources() {
+    QStringList paths = { QLatin1String(kPasswdFile), QLatin1String(kAccountsUsersDir),
+                          QLatin1String(kAccountsIconsDir) };
+
+    // A configured avatar directory, unless it lives in the homes, which are
+    // probed with care instead of being watched
+    for (const User &user : std::as_const(m_users)) {
+        const QString avatar = resolveAvatarOverride(user.username, user.homeDir);
+        if (!avatar.isEmpty() && (user.homeDir.isEmpty() || !avatar.startsWith(user.homeDir + "/"))) {
+            paths << QFileInfo(avatar).absolutePath();
+        }
     }
+    paths.removeDuplicates();
 
-    QString icon = homeDir + "/.face";
-    if (isUsableAvatarFile(icon)) {
-        return icon;
+    QStringList watched;
+    for (const QString &path : std::as_const(paths)) {
+        if (QFileInfo::exists(path) && m_sourceWatcher.addPath(path)) {
+            watched << path;
+        }
     }
+    qDebug() << "UserModel: Watching" << watched;
+}
 
-    icon = homeDir + "/.face.icon";
-    if (isUsableAvatarFile(icon)) {
-        return icon;
+void UserModel::scheduleReload(bool reprobe) {
+    m_reprobe = m_reprobe || reprobe;
+    if (m_reloadWatcher) {
+        m_reloadQueued = true;
+        return;
+    }
+    m_reloadTimer.start();
+}
+
+void UserModel::reloadUsers() {
+    // Same blocking lookups as the first load, so they run on a worker;
+    // m_source is not touched elsewhere after that
+    m_reloadWatcher = new QFutureWatcher<Snapshot>(this);
+    connect(m_reloadWatcher, &QFutureWatcher<Snapshot>::finished, this, [this]() {
+        const Snapshot snapshot = m_reloadWatcher->result();
+        m_reloadWatcher->deleteLater();
+        m_reloadWatcher = nullptr;
+
+        if (snapshot.users) {
+            applyUsers(*snapshot.users, snapshot.iconStamps);
+        } else {
+            qWarning() << "UserModel: User source" << m_source->name() << "unavailable, keeping the current list";
+        }
+
+        if (m_reloadQueued) {
+            m_reloadQueued = false;
+            m_reloadTimer.start();
+        }
+    });
+
+    UserSource *source = m_source.get();
+    m_reloadWatcher->setFuture(ThreadPriority::run(ThreadPriority::Background, [source]() {
+        Snapshot snapshot;
+        snapshot.users = source->users();
+        if (snapshot.users) {
+            resolveIcons(&*snapshot.users, &snapshot.iconStamps);
+        }
+        return snapshot;
+    }));
+}
+
+void UserModel::applyUsers(const QVector<User> &users, const QHash<QString, qint64> &iconStamps) {
+    QSet<QString> names;
+    for (const User &user : users) {
+        names.insert(user.username);
+    }
+
+    int removed = 0;
+    int changed = 0;
+    QSet<QString> added;
+
+    for (int row = m_users.count() - 1; row >= 0; --row) {
+        if (!names.contains(m_users[row].username)) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_probedIcons.remove(m_users[row].username);
+            m_baseIcons.remove(m_users[row].username);
+            m_users.removeAt(row);
+            endRemoveRows();
+            ++removed;
+        }
+    }
+
+    // Rows before i already match the new order
+    for (int i = 0; i < users.count(); ++i) {
+        User user = users[i];
+        const qint64 stamp = iconStamps.value(user.username);
+        m_baseIcons.insert(user.username, user.iconPath);
+        user.iconPath = m_probedIcons.value(user.username, user.iconPath);
+
+        int row = -1;
+        for (int j = i; j < m_users.count(); ++j) {
+            if (m_users[j].username == user.username) {
+                row = j;
+                break;
+            }
+        }
+
+        if (row < 0) {
+            beginInsertRows(QModelIndex(), i, i);
+            m_users.insert(i, user);
+            endInsertRows();
+            m_iconStamps.insert(user.username, stamp);
+            added.insert(user.username);
+            continue;
+        }
+        if (row != i) {
+            beginMoveRows(QModelIndex(), row, row, QModelIndex(), i);
+            m_users.move(row, i);
+            endMoveRows();
+        }
+
+        QList<int> roles;
+        if (m_users[i].realName != user.realName) {
+            roles << RealNameRole;
+        }
+        if (m_users[i].iconPath != user.iconPath) {
+            roles << IconRole;
+        }
+        // The same file rewritten, e.g. by AccountsService
+        if (m_iconStamps.value(user.username) != stamp) {
+            roles << IconStampRole;
+        }
+        m_users[i] = user;
+        m_iconStamps.insert(user.username, stamp);
+        if (!roles.isEmpty()) {
+            const QModelIndex idx = index(i);
+            emit dataChanged(idx, idx, roles);
+            ++changed;
+        }
+    }
+
+    if (removed || !added.isEmpty() || changed) {
+        qInfo() << "UserModel: Users updated:" << added.count() << "added," << removed << "removed,"
+                << changed << "changed";
+    }
+
+    // New users have no probe yet; on avatar changes every home is probed again
+    if (m_reprobe) {
+        m_reprobe = false;
+        startAvatarProbes();
+    } else if (!added.isEmpty()) {
+        startAvatarProbes(added);
+    }
+}
+
+void UserModel::startAvatarProbes(const QSet<QString> &only) {
+    for (const User &user : std::as_const(m_users)) {
+        if (m_probes.contains(user.username) || (!only.isEmpty() && !only.contains(user.username))) {
+            continue;
+        }
+
+        const QStringList candidates = homeAvatarCandidates(user.username, user.homeDir);
+        if (candidates.isEmpty()) {
+            continue;
+        }
+
+        AvatarProbe probe;
+        probe.startedAt = std::make_shared<std::atomic<qint64>>(-1);
+        probe.watcher = new QFutureWatcher<QString>(this);
+
+        const QString username = user.username;
+        connect(probe.watcher, &QFutureWatcher<QString>::finished, this, [this, username]() {
+            finishAvatarProbe(username);
+        });
+
+        const auto startedAt = probe.startedAt;
+        const QString homeDir = user.homeDir;
+        const bool probeRemoteHomes = m_probeOptions.probeRemoteHomes;
+        probe.watcher->setFuture(QtConcurrent::run(m_probePool, [=]() {
+            // Home directories may sit on a disk boot is still busy with
+            ThreadPriority::enter(ThreadPriority::Background);
+            startedAt->store(monotonicMs());
+            return probeHomeAvatar(username, homeDir, candidates, probeRemoteHomes);
+        }));
+
+        m_probes.insert(username, probe);
+    }
+
+    if (!m_probes.isEmpty() && m_probeOptions.timeoutMs > 0) {
+        m_deadlineTimer.start();
+    }
+}
+
+void UserModel::finishAvatarProbe(const QString &username) {
+    const AvatarProbe probe = m_probes.take(username);
+    if (!probe.watcher) {
+        return;
+    }
+    probe.watcher->deleteLater();
+
+    const QString icon = probe.watcher->result();
+    if (probe.expired) {
+        // The pool thread released at expiry is back; undo the extra slot.
+        m_probePool->reserveThread();
+        qWarning() << "UserModel: Late avatar probe for" << username << "finished after"
+                   << (monotonicMs() - probe.startedAt->load()) << "ms, result ignored";
+    } else {
+        // An empty result after a re-probe means the home avatar is gone
+        if (icon.isEmpty()) {
+            m_probedIcons.remove(username);
+        } else {
+            m_probedIcons.insert(username, icon);
+        }
+        const QString current = icon.isEmpty() ? m_baseIcons.value(username) : icon;
+        const int row = indexOf(username);
+        if (row >= 0 && !current.isEmpty() && m_users[row].iconPath != current) {
+            m_users[row].iconPath = current;
+            const QModelIndex idx = index(row);
+            emit dataChanged(idx, idx, {IconRole});
+        }
+    }
+
+    if (m_probes.isEmpty()) {
+        m_deadlineTimer.stop();
+        if (!m_expiredUsers.isEmpty()) {
+            qWarning() << "UserModel:" << m_expiredUsers.count() << "avatar probe(s) exceeded the"
+                       << m_probeOptions.timeoutMs << "ms deadline:" << m_expiredUsers.join(", ");
+        }
+    }
+}
+
+void UserModel::checkProbeDeadlines() {
+    const qint64 now = monotonicMs();
+    bool pending = false;
+
+    for (auto it = m_probes.begin(); it != m_probes.end(); ++it) {
+        AvatarProbe &probe = it.value();
+        const qint64 startedAt = probe.startedAt->load();
+        if (probe.expired || startedAt < 0) {
+            pending = pending || startedAt < 0;
+            continue;
+        }
+
+        if (now - startedAt > m_probeOptions.timeoutMs) {
+            probe.expired = true;
+            m_expiredUsers << it.key();
+            qWarning() << "UserModel: Avatar probe for" << it.key() << "exceeded the"
+                       << m_probeOptions.timeoutMs << "ms deadline, keeping fallback avatar";
+            // The worker is blocked in the kernel; let another probe run meanwhile.
+            m_probePool->releaseThread();
+        } else {
+            pending = true;
+        }
+    }
+
+    if (!pending) {
+        m_deadlineTimer.stop();
     }
+}
 
-    icon = QString("/var/lib/AccountsService/icons/%1").arg(username);
+QString UserModel::findLocalAvatar(const QString &username) {
+    const QString icon = QString("/var/lib/AccountsService/icons/%1").arg(username);
     if (isUsableAvatarFile(icon)) {
         return icon;
     }
@@ -62,6 +467,68 @@ QString UserModel::findUserAvatar(const QString &username, const QString &homeDi
     return "qrc:/icons/user-avatar.svg";
 }
 
+QStringList UserModel::homeAvatarCandidates(const QString &username, const QString &homeDir) const {
+    QStringList candidates;
+
+    const QString configuredAvatar = resolveAvatarOverride(username, homeDir);
+    if (!configuredAvatar.isEmpty()) {
+        candidates << configuredAvatar;
+    }
+
+    if (!homeDir.isEmpty()) {
+        candidates << homeDir + "/.face" << homeDir + "/.face.icon";
+    }
+
+    return candidates;
+}
+
+QString UserModel::probeHomeAvatar(const QString &username, const QString &homeDir,
+                                   const QStringList &candidates, bool probeRemoteHomes) {
+    bool homeUsable = !homeDir.isEmpty();
+
+    if (homeUsable) {
+        struct statx stx;
+        if (!statNoAutomount(homeDir, &stx)) {
+            homeUsable = false;
+        } else if ((stx.stx_attributes_mask & STATX_ATTR_AUTOMOUNT)
+                   && (stx.stx_attributes & STATX_ATTR_AUTOMOUNT)) {
+            // Not mounted yet; looking inside would trigger the automount
+            qDebug() << "UserModel: Skipping unmounted automount home of" << username << ":" << homeDir;
+            homeUsable = false;
+        } else {
+            // Safe now: the home is not an automount trigger
+            struct statfs fs;
+            const QByteArray nativeHome = QFile::encodeName(homeDir);
+            if (statfs(nativeHome.constData(), &fs) == 0) {
+                const char *remote = remoteFilesystemName(static_cast<unsigned long>(fs.f_type));
+                if (remote && !probeRemoteHomes) {
+                    qDebug() << "UserModel: Skipping" << remote << "home of" << username << ":" << homeDir;
+                    homeUsable = false;
+                }
+            }
+        }
+    }
+
+    for (const QString &candidate : candidates) {
+        const bool insideHome = !homeDir.isEmpty()
+            && (candidate == homeDir || candidate.startsWith(homeDir + "/"));
+        if (insideHome && !homeUsable) {
+            continue;
+        }
+
+        struct statx stx;
+        if (!statNoAutomount(candidate, &stx) || !S_ISREG(stx.stx_mode)) {
+            continue;
+        }
+
+        if (isUsableAvatarFile(candidate)) {
+            return candidate;
+        }
+    }
+
+    return QString();
+}
+
 QString UserModel::resolveAvatarOverride(const QString &username, const QString &homeDir) const {
     if (m_avatarOverridePattern.isEmpty()) {
         return QString();
@@ -73,7 +540,7 @@ QString UserModel::resolveAvatarOverride(const QString &username, const QString
     return resolvedPath;
 }
 
-bool UserModel::isUsableAvatarFile(const QString &path) const {
+bool UserModel::isUsableAvatarFile(const QString &path) {
     if (path.isEmpty()) {
         return false;
     }
@@ -87,11 +554,26 @@ bool UserModel::isUsableAvatarFile(const QString &path) const {
         return false;
     }
 
+    LATENCY_SCOPE("image.probe");
     QImageReader reader(path);
     reader.setDecideFormatFromContent(true);
     return reader.canRead();
 }
 
+qint64 UserModel::monotonicMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int UserModel::indexOf(const QString &username) const {
+    for (int row = 0; row < m_users.count(); ++row) {
+        if (m_users[row].username == username) {
+            return row;
+        }
+    }
+    return -1;
+}
+
 int UserModel::rowCount(const QModelIndex &) const {
     return m_users.count();
 }
@@ -105,6 +587,7 @@ QVariant UserModel::data(const QModelIndex &index, int role) const {
         case UsernameRole: return user.username;
         case RealNameRole: return user.realName;
         case IconRole: return user.iconPath;
+        case IconStampRole: return m_iconStamps.value(user.username);
         default: return QVariant();
     }
 }
@@ -114,5 +597,6 @@ QHash<int, QByteArray> UserModel::roleNames() const {
     roles[UsernameRole] = "username";
     roles[RealNameRole] = "realName";
     roles[IconRole] = "iconPath";
+    roles[IconStampRole] = "iconStamp";
     return roles;
 }
@@ -1,12 +1,32 @@
 #pragma once
 #include <QAbstractListModel>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+#include <optional>
 
-struct User {
-    QString username;
-    QString realName;
-    QString iconPath;
+#include "UserSource.h"
+
+class QThreadPool;
+
+// How avatars under home directories are probed
+struct AvatarProbeOptions {
+    bool probeRemoteHomes = false; // Also probe homes on NFS/CIFS/FUSE/... filesystems
+    int timeoutMs = 1500;          // Per-user deadline, measured from when the probe starts
+    int concurrency = 4;           // Probes running at the same time
 };
 
+/**
+ * @brief The users shown in the greeter.
+ *
+ * /etc/passwd, the AccountsService directories and the avatar override
+ * directory are watched; changes are applied as row inserts, removes, moves
+ * and per-role dataChanged, so views keep their selection.
+ */
 class UserModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -14,22 +34,78 @@ public:
     enum UserRoles {
         UsernameRole = Qt::UserRole + 1,
         RealNameRole,
-        IconRole
+        IconRole,
+        IconStampRole  // mtime of the icon file, changes when it is rewritten in place
     };
 
     explicit UserModel(QObject *parent = nullptr);
     explicit UserModel(const QString &avatarOverridePattern, QObject *parent = nullptr);
+    /**
+     * @param userSource "auto", "userdb", "accounts" or "passwd"; see UserSource
+     */
+    UserModel(const QString &avatarOverridePattern, const AvatarProbeOptions &probeOptions,
+              const QString &userSource, QObject *parent = nullptr);
+    ~UserModel() override;
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const override;
 
+    // Row of a user, -1 if not listed
+    Q_INVOKABLE int indexOf(const QString &username) const;
+
 private:
+    // Result of a reload, built off the GUI thread
+    struct Snapshot {
+        std::optional<QVector<User>> users;
+        QHash<QString, qint64> iconStamps;
+        bool fellBack = false;  // The configured source failed, users come from passwd
+    };
+
+    struct AvatarProbe {
+        QFutureWatcher<QString> *watcher = nullptr;
+        // Monotonic start time in ms, or -1 while still queued in the pool
+        std::shared_ptr<std::atomic<qint64>> startedAt;
+        bool expired = false;
+    };
+
     void loadUsers();
-    QString findUserAvatar(const QString &username, const QString &homeDir) const;
+    void finishLoad(const Snapshot &snapshot);
+    void watchSources();
+    void scheduleReload(bool reprobe);
+    void reloadUsers();
+    void applyUsers(const QVector<User> &users, const QHash<QString, qint64> &iconStamps);
+    // Probes every user's home, or only those in @p only
+    void startAvatarProbes(const QSet<QString> &only = QSet<QString>());
+    void finishAvatarProbe(const QString &username);
+    void checkProbeDeadlines();
+    static QString findLocalAvatar(const QString &username);
+    QStringList homeAvatarCandidates(const QString &username, const QString &homeDir) const;
     QString resolveAvatarOverride(const QString &username, const QString &homeDir) const;
-    bool isUsableAvatarFile(const QString &path) const;
+
+    static QString probeHomeAvatar(const QString &username, const QString &homeDir,
+                                   const QStringList &candidates, bool probeRemoteHomes);
+    static bool isUsableAvatarFile(const QString &path);
+    static void resolveIcons(QVector<User> *users, QHash<QString, qint64> *iconStamps);
+    static qint64 iconStamp(const QString &path);
+    static qint64 monotonicMs();
 
     QString m_avatarOverridePattern;
+    AvatarProbeOptions m_probeOptions;
+    std::unique_ptr<UserSource> m_source;
     QVector<User> m_users;
+
+    QThreadPool *m_probePool = nullptr;
+    QHash<QString, AvatarProbe> m_probes;
+    QStringList m_expiredUsers;
+    QTimer m_deadlineTimer;
+
+    QFileSystemWatcher m_sourceWatcher;
+    QTimer m_reloadTimer;
+    QFutureWatcher<Snapshot> *m_reloadWatcher = nullptr;
+    bool m_reloadQueued = false;  // A change arrived while a reload was running
+    bool m_reprobe = false;       // Avatar files changed; probe every home again
+    QHash<QString, QString> m_probedIcons;  // Avatars found under home directories
+    QHash<QString, QString> m_baseIcons;    // Icons from the source or AccountsService
+    QHash<QString, qint64> m_iconStamps;    // mtime of each user's non-home icon
 };
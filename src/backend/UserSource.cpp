@@ -0,0 +1,300 @@
+#include "UserSource.h"
+#include "Instrumentation.h"
+#include <pwd.h>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusReply>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <vector>
+
+namespace {
+
+// Local IPC; a source slower than this is treated as unavailable
+constexpr int kTimeoutMs = 2000;
+
+bool isRegularUid(qint64 uid)
+{
+    return uid >= 1000 && uid < 60000;
+}
+
+class PasswdUserSource : public UserSource
+{
+public:
+    QString name() const override { return QStringLiteral("passwd"); }
+
+    std::optional<QVector<User>> users() override
+    {
+        QVector<User> users;
+
+        setpwent();
+        while (true) {
+            struct passwd *pwent;
+            {
+                LATENCY_SCOPE("nss.getpwent");
+                pwent = getpwent();
+            }
+            if (!pwent) {
+                break;
+            }
+
+            if (isRegularUid(pwent->pw_uid)) {
+                const QString name = pwent->pw_name;
+                const QString gecos = QString::fromUtf8(pwent->pw_gecos).split(",").first();
+                users.append({name, gecos.isEmpty() ? name : gecos, QString(), pwent->pw_dir});
+            }
+        }
+        endpwent();
+
+        return users;
+    }
+};
+
+// io.systemd.UserDatabase over Varlink: NUL-terminated JSON messages
+class UserDbUserSource : public UserSource
+{
+public:
+    QString name() const override { return QStringLiteral("userdb"); }
+
+    std::optional<QVector<User>> users() override
+    {
+        LATENCY_SCOPE("userdb.list");
+        const QString path = qEnvironmentVariableIsSet("QMLGREET_USERDB_SOCKET")
+            ? qEnvironmentVariable("QMLGREET_USERDB_SOCKET")
+            : QStringLiteral("/run/systemd/userdb/io.systemd.Multiplexer");
+        if (!QFileInfo::exists(path)) {
+            return std::nullopt;
+        }
+
+        // Let userdb skip system, intrinsic and container users itself
+        // rather than streaming every NSS/LDAP record here. Regular users
+        // include systemd-homed's range above 60000.
+        const QJsonObject filter {
+            { "service", "io.systemd.Multiplexer" },
+            { "dispositionMask", QJsonArray { "regular" } },
+            { "uidMin", 1000 },
+            { "uidMax", 60513 },
+        };
+        bool unsupported = false;
+        std::optional<QVector<User>> users = query(path, filter, &unsupported);
+        if (unsupported) {
+            // systemd before v257 rejects the filter parameters
+            qDebug() << "UserSource: userdb does not filter, listing all records";
+            users = query(path, QJsonObject { { "service", "io.systemd.Multiplexer" } }, nullptr);
+        }
+        return users;
+    }
+
+private:
+    static std::optional<QVector<User>> query(const QString &path, const QJsonObject &parameters, bool *unsupported)
+    {
+        QLocalSocket socket;
+        socket.connectToServer(path);
+        if (!socket.waitForConnected(kTimeoutMs)) {
+            qWarning() << "UserSource: Cannot connect to" << path << ":" << socket.errorString();
+            return std::nullopt;
+        }
+
+        // "more" streams one reply per record; the last one has no "continues"
+        const QJsonObject call {
+            { "method", "io.systemd.UserDatabase.GetUserRecord" },
+            { "parameters", parameters },
+            { "more", true },
+        };
+        socket.write(QJsonDocument(call).toJson(QJsonDocument::Compact) + '\0');
+
+        QVector<User> users;
+        QByteArray buffer;
+        QElapsedTimer timer;
+        timer.start();
+
+        while (true) {
+            const int end = buffer.indexOf('\0');
+            if (end < 0) {
+                const int remaining = kTimeoutMs - int(timer.elapsed());
+                if (remaining <= 0 || !socket.waitForReadyRead(remaining)) {
+                    qWarning() << "UserSource: userdb did not finish the user list";
+                    return std::nullopt;
+                }
+                buffer += socket.readAll();
+                continue;
+            }
+
+            const QJsonObject reply = QJsonDocument::fromJson(buffer.left(end)).object();
+            buffer.remove(0, end + 1);
+
+            if (reply.contains("error")) {
+                // No users at all is reported as an error too
+                const QString error = reply.value("error").toString();
+                if (error == QStringLiteral("io.systemd.UserDatabase.NoRecordFound")) {
+                    break;
+                }
+                if (unsupported && error == QStringLiteral("org.varlink.service.InvalidParameter")) {
+                    *unsupported = true;
+                    return std::nullopt;
+                }
+                qWarning() << "UserSource: userdb error" << error;
+                return std::nullopt;
+            }
+
+            const QJsonObject record = reply.value("parameters").toObject().value("record").toObject();
+            if (isRegular(record)) {
+                users.append(toUser(record));
+            }
+            if (!reply.value("continues").toBool()) {
+                break;
+            }
+        }
+
+        return users;
+    }
+
+    static bool isRegular(const QJsonObject &record)
+    {
+        const QString disposition = record.value("disposition").toString();
+        if (!disposition.isEmpty()) {
+            return disposition == QStringLiteral("regular");
+        }
+        // Records without a disposition are classified by UID, like systemd does
+        return isRegularUid(record.value("uid").toInteger(-1));
+    }
+
+    static User toUser(const QJsonObject &record)
+    {
+        User user;
+        user.username = record.value("userName").toString();
+        user.realName = record.value("realName").toString();
+        if (user.realName.isEmpty()) {
+            user.realName = user.username;
+        }
+        user.homeDir = record.value("homeDirectory").toString();
+
+        // systemd-homed publishes the avatar in the user's blob directory,
+        // either at the top level or in the per-machine binding section
+        QString blobDirectory = record.value("blobDirectory").toString();
+        if (blobDirectory.isEmpty()) {
+            const QJsonObject binding = record.value("binding").toObject();
+            for (auto it = binding.constBegin(); it != binding.constEnd() && blobDirectory.isEmpty(); ++it) {
+                blobDirectory = it.value().toObject().value("blobDirectory").toString();
+            }
+        }
+        if (!blobDirectory.isEmpty()) {
+            user.iconPath = blobDirectory + QStringLiteral("/avatar");
+        }
+
+        return user;
+    }
+};
+
+// org.freedesktop.Accounts.ListCachedUsers; only users that logged in before
+class AccountsUserSource : public UserSource
+{
+public:
+    QString name() const override { return QStringLiteral("accounts"); }
+
+    std::optional<QVector<User>> users() override
+    {
+        LATENCY_SCOPE("accounts.list");
+        const QDBusConnection bus = qgetenv("QMLGREET_ACCOUNTS_BUS") == "session"
+            ? QDBusConnection::sessionBus() : QDBusConnection::systemBus();
+        if (!bus.isConnected()) {
+            return std::nullopt;
+        }
+
+        const QDBusMessage list = QDBusMessage::createMethodCall(
+            QStringLiteral("org.freedesktop.Accounts"), QStringLiteral("/org/freedesktop/Accounts"),
+            QStringLiteral("org.freedesktop.Accounts"), QStringLiteral("ListCachedUsers"));
+        const QDBusReply<QList<QDBusObjectPath>> paths = bus.call(list, QDBus::Block, kTimeoutMs);
+        if (!paths.isValid()) {
+            qWarning() << "UserSource: AccountsService unavailable:" << paths.error().message();
+            return std::nullopt;
+        }
+
+        QVector<User> users;
+        for (const QDBusObjectPath &path : paths.value()) {
+            QDBusMessage getAll = QDBusMessage::createMethodCall(
+                QStringLiteral("org.freedesktop.Accounts"), path.path(),
+                QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("GetAll"));
+            getAll << QStringLiteral("org.freedesktop.Accounts.User");
+            const QDBusReply<QVariantMap> reply = bus.call(getAll, QDBus::Block, kTimeoutMs);
+            if (!reply.isValid()) {
+                qWarning() << "UserSource: Cannot read" << path.path() << ":" << reply.error().message();
+                continue;
+            }
+
+            const QVariantMap properties = reply.value();
+            if (properties.value("SystemAccount").toBool()) {
+                continue;
+            }
+
+            User user;
+            user.username = properties.value("UserName").toString();
+            user.realName = properties.value("RealName").toString();
+            if (user.realName.isEmpty()) {
+                user.realName = user.username;
+            }
+            user.homeDir = properties.value("HomeDirectory").toString();
+            user.iconPath = properties.value("IconFile").toString();
+            users.append(user);
+        }
+
+        return users;
+    }
+};
+
+class AutoUserSource : public UserSource
+{
+public:
+    AutoUserSource()
+    {
+        m_sources.push_back(std::make_unique<UserDbUserSource>());
+        m_sources.push_back(std::make_unique<AccountsUserSource>());
+        m_sources.push_back(std::make_unique<PasswdUserSource>());
+    }
+
+    QString name() const override { return m_used.isEmpty() ? QStringLiteral("auto") : m_used; }
+
+    std::optional<QVector<User>> users() override
+    {
+        for (const auto &source : m_sources) {
+            std::optional<QVector<User>> users = source->users();
+            // An empty AccountsService cache means nobody logged in yet,
+            // not that there are no users; keep looking
+            if (users && !users->isEmpty()) {
+                m_used = source->name();
+                return users;
+            }
+        }
+        return QVector<User>();
+    }
+
+private:
+    std::vector<std::unique_ptr<UserSource>> m_sources;
+    QString m_used;
+};
+
+} // namespace
+
+std::unique_ptr<UserSource> UserSource::create(const QString &kind)
+{
+    const QString normalized = kind.trimmed().toLower();
+    if (normalized == QStringLiteral("passwd")) {
+        return std::make_unique<PasswdUserSource>();
+    }
+    if (normalized == QStringLiteral("userdb")) {
+        return std::make_unique<UserDbUserSource>();
+    }
+    if (normalized == QStringLiteral("accounts")) {
+        return std::make_unique<AccountsUserSource>();
+    }
+    if (!normalized.isEmpty() && normalized != QStringLiteral("auto")) {
+        qWarning() << "UserSource: Unknown source" << kind << ", using auto";
+    }
+    return std::make_unique<AutoUserSource>();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <optional>
+
+struct User {
+    QString username;
+    QString realName;
+    QString iconPath;
+    QString homeDir;
+};
+
+/**
+ * @brief Where the user list comes from.
+ *
+ * "passwd" enumerates the whole NSS passwd database and keeps UIDs 1000-59999,
+ * which is the most expensive query against SSSD or LDAP. "userdb" asks the
+ * systemd-userdb multiplexer over Varlink and "accounts" asks AccountsService
+ * over D-Bus; both only return regular users. "auto" tries userdb, then
+ * AccountsService, then passwd.
+ *
+ * QMLGREET_USERDB_SOCKET and QMLGREET_ACCOUNTS_BUS=session point the userdb
+ * and AccountsService sources at a local stand-in (tools/fake-userdb).
+ */
+class UserSource
+{
+public:
+    virtual ~UserSource() = default;
+
+    static std::unique_ptr<UserSource> create(const QString &kind);
+
+    virtual QString name() const = 0;
+
+    // Regular users; std::nullopt when the source is not reachable
+    virtual std::optional<QVector<User>> users() = 0;
+};
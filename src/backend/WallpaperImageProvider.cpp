@@ -0,0 +1,187 @@
+#include "WallpaperImageProvider.h"
+#include "Instrumentation.h"
+#include "Readahead.h"
+#include "SharedAssetCache.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QRegularExpression>
+#include <QTransform>
+#include <QVector>
+
+namespace {
+
+// The blurred background is stored at 1/kBlurDownscale of the output size
+constexpr int kBlurDownscale = 4;
+
+// One horizontal box blur pass over premultiplied RGBA rows
+void boxBlurRows(QImage &image, int radius)
+{
+    const int width = image.width();
+    const int window = radius * 2 + 1;
+    QVector<int> line(width * 4);
+
+    for (int y = 0; y < image.height(); ++y) {
+        uchar *row = image.scanLine(y);
+        for (int i = 0; i < width * 4; ++i) {
+            line[i] = row[i];
+        }
+
+        for (int c = 0; c < 4; ++c) {
+            // Edge pixels are repeated outside the image
+            int sum = line[c] * (radius + 1);
+            for (int x = 1; x <= radius; ++x) {
+                sum += line[qMin(x, width - 1) * 4 + c];
+            }
+            for (int x = 0; x < width; ++x) {
+                row[x * 4 + c] = uchar(sum / window);
+                sum += line[qMin(x + radius + 1, width - 1) * 4 + c];
+                sum -= line[qMax(x - radius, 0) * 4 + c];
+            }
+        }
+    }
+}
+
+} // namespace
+
+WallpaperImageProvider::WallpaperImageProvider(SharedAssetCache *sharedCache)
+    : QQuickImageProvider(QQuickImageProvider::Image)
+    , m_sharedCache(sharedCache)
+{
+}
+
+QImage WallpaperImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    // "64/usr/share/wallpapers/x.jpg" -> radius 64, "/usr/share/wallpapers/x.jpg"
+    const int slash = id.indexOf(QLatin1Char('/'));
+    const int radius = qMax(0, id.left(slash).toInt());
+    const QString path = id.mid(slash);
+    const QSize target = requestedSize.isValid() ? requestedSize : QSize(1920, 1080);
+    const QString file = resolveVariant(path, target);
+    Readahead::note(file);
+
+    const QByteArray params = QByteArray::number(target.width()) + 'x' + QByteArray::number(target.height())
+        + "/r" + QByteArray::number(radius);
+    const QByteArray key = SharedAssetCache::keyFor(QStringLiteral("wallpaper"), file, params);
+
+    const QImage image = m_sharedCache->findOrCreate(key, [&]() {
+        const QImage decoded = decodeCovering(file, target);
+        return radius > 0 && !decoded.isNull() ? blurred(decoded, radius) : decoded;
+    });
+
+    if (image.isNull()) {
+        qWarning() << "WallpaperImageProvider: Could not decode" << file;
+    }
+    if (size) {
+        *size = image.size();
+    }
+    return image;
+}
+
+bool WallpaperImageProvider::isPackage(const QString &path)
+{
+    return QFileInfo(path + QStringLiteral("/contents/images")).isDir();
+}
+
+QString WallpaperImageProvider::resolveVariant(const QString &path, const QSize &size)
+{
+    if (!isPackage(path)) {
+        return path;
+    }
+
+    static const QRegularExpression variantName(QStringLiteral("^(\\d+)x(\\d+)\\."));
+    const QDir images(path + QStringLiteral("/contents/images"));
+    const double targetAspect = size.isEmpty() ? 16.0 / 9.0 : double(size.width()) / size.height();
+
+    // Prefer the closest aspect ratio, then the smallest variant covering the
+    // output, then the largest one that does not
+    QString best;
+    QSize bestSize;
+    double bestAspectError = 0;
+    bool bestCovers = false;
+
+    for (const QString &name : images.entryList(QDir::Files | QDir::Readable)) {
+        const QRegularExpressionMatch match = variantName.match(name);
+        if (!match.hasMatch()) {
+            continue;
+        }
+
+        const QSize variant(match.captured(1).toInt(), match.captured(2).toInt());
+        if (variant.isEmpty()) {
+            continue;
+        }
+        // Ratios within 1% count as equal: 1366x768 is 16:9 for our purposes
+        const double aspectError = qAbs(double(variant.width()) / variant.height() - targetAspect) / targetAspect;
+        const bool covers = variant.width() >= size.width() && variant.height() >= size.height();
+        const qint64 area = qint64(variant.width()) * variant.height();
+        const qint64 bestArea = qint64(bestSize.width()) * bestSize.height();
+
+        bool better = best.isEmpty();
+        if (!better && qAbs(aspectError - bestAspectError) > 0.01) {
+            better = aspectError < bestAspectError;
+        } else if (!better && covers != bestCovers) {
+            better = covers;
+        } else if (!better) {
+            better = covers ? area < bestArea : area > bestArea;
+        }
+
+        if (better) {
+            best = images.filePath(name);
+            bestSize = variant;
+            bestAspectError = aspectError;
+            bestCovers = covers;
+        }
+    }
+
+    if (best.isEmpty()) {
+        qWarning() << "WallpaperImageProvider: No <W>x<H> images in package" << path;
+        return path;
+    }
+
+    qDebug() << "WallpaperImageProvider: Using" << best << "for" << size;
+    return best;
+}
+
+QImage WallpaperImageProvider::decodeCovering(const QString &path, const QSize &size)
+{
+    LATENCY_SCOPE("image.decode");
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+
+    const QSize sourceSize = reader.size();
+    const QSize scaled = sourceSize.isValid()
+        ? sourceSize.scaled(size, Qt::KeepAspectRatioByExpanding) : size;
+    reader.setScaledSize(scaled);
+
+    const QImage image = reader.read();
+    if (image.isNull()) {
+        return image;
+    }
+
+    const QRect crop((image.width() - size.width()) / 2, (image.height() - size.height()) / 2,
+                     size.width(), size.height());
+    return image.copy(crop.intersected(image.rect())).convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+}
+
+QImage WallpaperImageProvider::blurred(const QImage &image, int radius)
+{
+    LATENCY_SCOPE("image.blur");
+    const QSize small(qMax(1, image.width() / kBlurDownscale), qMax(1, image.height() / kBlurDownscale));
+    QImage result = image.scaled(small, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                        .convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+
+    // Three box passes per axis approximate a gaussian with the FastBlur radius;
+    // columns are blurred as rows of the transposed image
+    const int boxRadius = qMax(1, radius / kBlurDownscale / 2);
+    for (int pass = 0; pass < 3; ++pass) {
+        boxBlurRows(result, boxRadius);
+    }
+    result = result.transformed(QTransform().rotate(90));
+    for (int pass = 0; pass < 3; ++pass) {
+        boxBlurRows(result, boxRadius);
+    }
+    result = result.transformed(QTransform().rotate(-90));
+
+    return result;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QImage>
+#include <QQuickImageProvider>
+
+class SharedAssetCache;
+
+/**
+ * @brief Serves the background decoded at output size and blurred on the CPU.
+ * Request as "image://wallpaper/<radius>/<path>" with sourceSize set to the
+ * output size; radius 0 gives the plain image. <path> may be a wallpaper
+ * package, in which case the variant matching the output is used. Results go through the shared
+ * asset cache, so every seat on the host maps the same buffer.
+ */
+class WallpaperImageProvider : public QQuickImageProvider
+{
+public:
+    explicit WallpaperImageProvider(SharedAssetCache *sharedCache);
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+
+    /**
+     * @brief Picks the image to decode for an output of @p size pixels.
+     * @p path may be an image file or a KDE wallpaper package (a directory
+     * with contents/images/<W>x<H>.<ext>). For a package, the smallest variant
+     * covering @p size with the closest aspect ratio is chosen. Files are
+     * returned unchanged.
+     */
+    static QString resolveVariant(const QString &path, const QSize &size);
+
+    // True for a directory laid out as a KDE wallpaper package
+    static bool isPackage(const QString &path);
+
+    // Decodes @p path to cover @p size and center-crops it (PreserveAspectCrop)
+    static QImage decodeCovering(const QString &path, const QSize &size);
+
+    // Gaussian-like blur; the result is downscaled since it has no detail left
+    static QImage blurred(const QImage &image, int radius);
+
+private:
+    SharedAssetCache *m_sharedCache;
+};
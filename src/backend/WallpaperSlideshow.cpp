@@ -0,0 +1,290 @@
+#include "WallpaperSlideshow.h"
+#include "SharedAssetCache.h"
+#include "ThreadPriority.h"
+#include "WallpaperImageProvider.h"
+#include <QCollator>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+
+namespace {
+// Extra time after the cross-fade before the outgoing image is released
+constexpr int kReleaseMarginMs = 200;
+}
+
+WallpaperSlideshow::WallpaperSlideshow(const QStringList &source, int intervalSecs, SharedAssetCache *sharedCache,
+                                       QObject *parent)
+    : QObject(parent)
+    , m_files(resolveFiles(source))
+    , m_sharedCache(sharedCache)
+{
+    m_rotateTimer.setInterval(qMax(5, intervalSecs) * 1000);
+    connect(&m_rotateTimer, &QTimer::timeout, this, &WallpaperSlideshow::advance);
+
+    m_releaseTimer.setSingleShot(true);
+    m_releaseTimer.setInterval(fadeDuration() + kReleaseMarginMs);
+    connect(&m_releaseTimer, &QTimer::timeout, this, [this]() {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_outgoing = QImage();
+            m_outgoingSerial = -1;
+        }
+        startDecode(wantedIndex());
+    });
+
+    connect(&m_decodeWatcher, &QFutureWatcher<QImage>::finished, this, &WallpaperSlideshow::onDecoded);
+
+    if (!source.isEmpty()) {
+        qInfo() << "WallpaperSlideshow:" << m_files.size() << "image(s), rotating every"
+                << m_rotateTimer.interval() / 1000 << "s";
+    }
+}
+
+WallpaperSlideshow::~WallpaperSlideshow()
+{
+    m_decodeWatcher.waitForFinished();
+}
+
+QStringList WallpaperSlideshow::resolveFiles(const QStringList &source)
+{
+    QStringList files;
+
+    for (const QString &entry : source) {
+        const QString path = entry.trimmed();
+        const QFileInfo info(path);
+
+        if (info.isDir() && WallpaperImageProvider::isPackage(path)) {
+            files << info.absoluteFilePath();
+        } else if (info.isDir()) {
+            QStringList nameFilters;
+            for (const QByteArray &format : QImageReader::supportedImageFormats()) {
+                nameFilters << QStringLiteral("*.") + QString::fromLatin1(format);
+            }
+
+            QStringList names = QDir(path).entryList(nameFilters, QDir::Files | QDir::Readable);
+            QCollator collator;
+            collator.setNumericMode(true);
+            std::sort(names.begin(), names.end(), collator);
+            for (const QString &name : std::as_const(names)) {
+                files << info.absoluteFilePath() + QLatin1Char('/') + name;
+            }
+
+            // A directory like /usr/share/wallpapers holds packages instead
+            QStringList packages = QDir(path).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+            std::sort(packages.begin(), packages.end(), collator);
+            for (const QString &name : std::as_const(packages)) {
+                const QString package = info.absoluteFilePath() + QLatin1Char('/') + name;
+                if (WallpaperImageProvider::isPackage(package)) {
+                    files << package;
+                }
+            }
+        } else if (info.isFile()) {
+            files << info.absoluteFilePath();
+        } else if (!path.isEmpty()) {
+            qWarning() << "WallpaperSlideshow: Skipping missing" << path;
+        }
+    }
+
+    return files;
+}
+
+QString WallpaperSlideshow::currentSource() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_current.isNull() ? QString() : QStringLiteral("image://slideshow/%1").arg(m_serial);
+}
+
+void WallpaperSlideshow::setOutputSize(const QSize &size)
+{
+    if (m_outputSize == size) {
+        return;
+    }
+    m_outputSize = size;
+    emit outputSizeChanged();
+
+    if (!active() || m_outputSize.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_current.isNull()) {
+        // Both were decoded for the old size; the shown image is replaced
+        // first, the next one follows like after a rotation
+        m_redecodeCurrent = true;
+        m_next = QImage();
+        m_nextIndex = -1;
+    }
+    const bool fading = m_outgoingSerial >= 0;
+    locker.unlock();
+
+    // A decode in flight is redone for the new size when it finishes; a
+    // running fade continues with the old images and redecodes on release
+    if (!fading) {
+        startDecode(wantedIndex());
+    }
+}
+
+int WallpaperSlideshow::wantedIndex() const
+{
+    if (m_currentIndex < 0) {
+        return 0;
+    }
+    return m_redecodeCurrent ? m_currentIndex : (m_currentIndex + 1) % m_files.size();
+}
+
+void WallpaperSlideshow::setBlurRadius(int radius)
+{
+    if (m_blurRadius != radius) {
+        m_blurRadius = radius;
+        emit blurRadiusChanged();
+    }
+}
+
+void WallpaperSlideshow::setPaused(bool paused)
+{
+    if (m_paused == paused) {
+        return;
+    }
+
+    m_paused = paused;
+    qDebug() << "WallpaperSlideshow:" << (m_paused ? "Paused" : "Resumed");
+    emit pausedChanged();
+    updateTimer();
+}
+
+QImage WallpaperSlideshow::image(int serial) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (serial == m_serial) {
+        return m_current;
+    }
+    if (serial == m_outgoingSerial) {
+        return m_outgoing;
+    }
+    return QImage();
+}
+
+void WallpaperSlideshow::startDecode(int index)
+{
+    if (m_decodingIndex >= 0 || m_outputSize.isEmpty()) {
+        return;
+    }
+    if (m_files.size() < 2 && m_currentIndex >= 0 && !m_redecodeCurrent) {
+        return; // Nothing to rotate to
+    }
+
+    m_decodingIndex = index;
+    m_decodingSize = m_outputSize;
+    const QSize size = m_outputSize;
+    const int radius = m_blurRadius;
+    SharedAssetCache *sharedCache = m_sharedCache;
+
+    // The first image is part of the first frame; later ones are not urgent
+    const ThreadPriority::Class priority = m_currentIndex < 0 ? ThreadPriority::Critical : ThreadPriority::Background;
+    m_decodeWatcher.setFuture(ThreadPriority::run(priority, [package = m_files.at(index), size, radius, sharedCache]() {
+        const QString path = WallpaperImageProvider::resolveVariant(package, size);
+        const auto produce = [&]() {
+            const QImage decoded = WallpaperImageProvider::decodeCovering(path, size);
+            return radius > 0 && !decoded.isNull() ? WallpaperImageProvider::blurred(decoded, radius) : decoded;
+        };
+        if (!sharedCache) {
+            return produce();
+        }
+
+        // Same key as WallpaperImageProvider, so a static background and a
+        // slideshow on another seat share entries
+        const QByteArray params = QByteArray::number(size.width()) + 'x' + QByteArray::number(size.height())
+            + "/r" + QByteArray::number(radius);
+        return sharedCache->findOrCreate(SharedAssetCache::keyFor(QStringLiteral("wallpaper"), path, params), produce);
+    }));
+}
+
+void WallpaperSlideshow::onDecoded()
+{
+    const int index = m_decodingIndex;
+    m_decodingIndex = -1;
+    const QImage image = m_decodeWatcher.result();
+
+    if (m_decodingSize != m_outputSize) {
+        // The output was resized while this was decoding
+        if (m_outgoingSerial < 0) {
+            startDecode(wantedIndex());
+        }
+        return;
+    }
+
+    if (image.isNull()) {
+        qWarning() << "WallpaperSlideshow: Could not decode" << m_files.at(index);
+        // Try the following file unless we went all the way around
+        const int following = (index + 1) % m_files.size();
+        if (following != (m_currentIndex >= 0 ? m_currentIndex : 0)) {
+            startDecode(following);
+        }
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_redecodeCurrent && index == m_currentIndex) {
+        // Cross-fade from the old size, like a rotation to the same image
+        m_redecodeCurrent = false;
+        m_outgoing = m_current;
+        m_outgoingSerial = m_serial;
+        m_current = image;
+        ++m_serial;
+        locker.unlock();
+
+        emit currentSourceChanged();
+        m_releaseTimer.start();
+        return;
+    }
+
+    if (m_current.isNull()) {
+        m_current = image;
+        m_currentIndex = index;
+        ++m_serial;
+        locker.unlock();
+
+        emit currentSourceChanged();
+        updateTimer();
+        startDecode((index + 1) % m_files.size());
+        return;
+    }
+
+    m_next = image;
+    m_nextIndex = index;
+}
+
+void WallpaperSlideshow::advance()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_paused || m_next.isNull()) {
+        return;
+    }
+
+    m_outgoing = m_current;
+    m_outgoingSerial = m_serial;
+    m_current = m_next;
+    m_currentIndex = m_nextIndex;
+    m_next = QImage();
+    m_nextIndex = -1;
+    ++m_serial;
+    locker.unlock();
+
+    emit currentSourceChanged();
+    // The next decode starts once the outgoing image is released
+    m_releaseTimer.start();
+}
+
+void WallpaperSlideshow::updateTimer()
+{
+    const bool rotate = m_files.size() > 1 && !m_paused && m_currentIndex >= 0;
+    if (rotate && !m_rotateTimer.isActive()) {
+        m_rotateTimer.start();
+    } else if (!rotate) {
+        m_rotateTimer.stop();
+    }
+}
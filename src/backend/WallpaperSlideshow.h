@@ -0,0 +1,92 @@
+#pragma once
+
+#include <QFutureWatcher>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSize>
+#include <QStringList>
+#include <QTimer>
+
+class SharedAssetCache;
+
+/**
+ * @brief Rotates background images from a directory or list.
+ *
+ * The next image is decoded and blurred at output size on a worker thread
+ * while the current one is shown. At most two output-sized images are held:
+ * the shown one and either the pre-decoded next one or, during the
+ * cross-fade, the outgoing one. QML shows currentSource, served by
+ * SlideshowImageProvider.
+ */
+class WallpaperSlideshow : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool active READ active CONSTANT)
+    Q_PROPERTY(QString currentSource READ currentSource NOTIFY currentSourceChanged)
+    Q_PROPERTY(int fadeDuration READ fadeDuration CONSTANT)
+    Q_PROPERTY(QSize outputSize READ outputSize WRITE setOutputSize NOTIFY outputSizeChanged)
+    Q_PROPERTY(int blurRadius READ blurRadius WRITE setBlurRadius NOTIFY blurRadiusChanged)
+    // Rotation stops while paused (idle, or an auth prompt is up)
+    Q_PROPERTY(bool paused READ paused WRITE setPaused NOTIFY pausedChanged)
+
+public:
+    /**
+     * @param source A directory of images or wallpaper packages, or a list
+     *               of image files and packages
+     * @param intervalSecs Time each image is shown
+     */
+    WallpaperSlideshow(const QStringList &source, int intervalSecs, SharedAssetCache *sharedCache,
+                       QObject *parent = nullptr);
+    ~WallpaperSlideshow() override;
+
+    bool active() const { return !m_files.isEmpty(); }
+    QString currentSource() const;
+    int fadeDuration() const { return 800; }
+    QSize outputSize() const { return m_outputSize; }
+    void setOutputSize(const QSize &size);
+    int blurRadius() const { return m_blurRadius; }
+    void setBlurRadius(int radius);
+    bool paused() const { return m_paused; }
+    void setPaused(bool paused);
+
+    // Thread-safe; used by SlideshowImageProvider
+    QImage image(int serial) const;
+
+signals:
+    void currentSourceChanged();
+    void outputSizeChanged();
+    void blurRadiusChanged();
+    void pausedChanged();
+
+private:
+    static QStringList resolveFiles(const QStringList &source);
+    void startDecode(int index);
+    // The image to decode next: the first, the resized current one or the next
+    int wantedIndex() const;
+    void onDecoded();
+    void advance();
+    void updateTimer();
+
+    QStringList m_files;
+    SharedAssetCache *m_sharedCache;
+    QSize m_outputSize;
+    int m_blurRadius = 0;
+    bool m_paused = false;
+
+    QTimer m_rotateTimer;
+    QTimer m_releaseTimer;
+    QFutureWatcher<QImage> m_decodeWatcher;
+    int m_decodingIndex = -1;
+    QSize m_decodingSize;
+    bool m_redecodeCurrent = false;  // The output was resized under the shown image
+    int m_currentIndex = -1;
+    int m_nextIndex = -1;
+
+    mutable QMutex m_mutex;
+    int m_serial = 0;
+    QImage m_current;
+    QImage m_next;      // Pre-decoded, not shown yet
+    QImage m_outgoing;  // Still fading out
+    int m_outgoingSerial = -1;
+};
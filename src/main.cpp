@@ -2,12 +2,21 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QQuickItem>
+#include <QQuickWindow>
 #include <QSettings>
+#include <QCryptographicHash>
 #include <QFile>
 #include <QCommandLineParser>
 #include <QTextStream>
 #include <QDateTime>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+#include <QMutex>
 #include <QtGlobal>
+#include <memory>
 #include <syslog.h>
 #include "backend/AuthWrapper.h"
 #include "backend/SessionModel.h"
@@ -15,6 +24,30 @@
 #include "backend/SystemPower.h"
 #include "backend/LayerShell.h"
 #include "backend/SystemBattery.h"
+#include "backend/RenderProfile.h"
+#include "backend/AvatarImageProvider.h"
+#include "backend/MemoryMonitor.h"
+#include "backend/IconCache.h"
+#include "backend/ThemeIconProvider.h"
+#include "backend/StartupScheduler.h"
+#include "backend/StallWatchdog.h"
+#include "backend/Instrumentation.h"
+#include "backend/SharedAssetCache.h"
+#include "backend/WallpaperImageProvider.h"
+#include "backend/BenchDriver.h"
+#include "backend/IdleMonitor.h"
+#include "backend/WallpaperSlideshow.h"
+#include "backend/SlideshowImageProvider.h"
+#ifdef QMLGREET_DAMAGE_STATS
+#include "backend/DamageStats.h"
+#endif
+#include "backend/RoundImage.h"
+#include "backend/FastExit.h"
+#include "backend/SplashSurface.h"
+#include "backend/OutputPower.h"
+#include "backend/MetricsExporter.h"
+#include "backend/ThreadPriority.h"
+#include "backend/Readahead.h"
 
 // Custom message handler to redirect Qt debug output to syslog and file
 void syslogMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
@@ -54,7 +87,9 @@ void syslogMessageHandler(QtMsgType type, const QMessageLogContext &context, con
     // Log to syslog with type prefix
     syslog(priority, "[%s] %s", typeStr, localMsg.constData());
 
-    // Also write to a dedicated log file
+    // Also write to a dedicated log file (the stall watchdog logs from its own thread)
+    static QMutex logFileMutex;
+    QMutexLocker logFileLocker(&logFileMutex);
     static QFile logFile("/tmp/qmlgreet.log");
     bool canWriteLogFile = logFile.isOpen();
     if (!canWriteLogFile) {
@@ -73,19 +108,62 @@ void syslogMessageHandler(QtMsgType type, const QMessageLogContext &context, con
     }
 }
 
+static const char *const defaultConfigPath = "/etc/qmlgreet/qmlgreet.conf";
+
+// The -c/--config value, read before QCommandLineParser can run
+static QString configPathArgument(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        const QByteArray arg(argv[i]);
+        if ((arg == "-c" || arg == "--config") && i + 1 < argc) {
+            return QFile::decodeName(argv[i + 1]);
+        }
+        if (arg.startsWith("--config=")) {
+            return QFile::decodeName(arg.mid(9));
+        }
+    }
+    return QString::fromLatin1(defaultConfigPath);
+}
+
 int main(int argc, char *argv[])
 {
+    const qint64 processStartNs = Instrumentation::nowNs();
+
     // Open syslog connection
     openlog("qmlgreet", LOG_PID | LOG_CONS, LOG_USER);
 
     // Install custom message handler
     qInstallMessageHandler(syslogMessageHandler);
 
+    // Pull last start's libraries, plugins, fonts and images into the page
+    // cache while Qt initialises
+    const QString startupConfigPath = configPathArgument(argc, argv);
+    Readahead::start(startupConfigPath);
+
+    // Show last start's background while Qt and the QML load; it goes once
+    // the window has drawn its first frame
+    const QString splashCacheFile = SplashSurface::cachePath(startupConfigPath);
+    std::unique_ptr<SplashSurface> splash;
+    if (!splashCacheFile.isEmpty()) {
+        splash = std::make_unique<SplashSurface>(splashCacheFile);
+        if (!splash->isShown()) {
+            splash.reset();
+        }
+    }
+
     qInfo() << "qmlgreet starting...";
     qInfo() << "GREETD_SOCK environment variable:" << qgetenv("GREETD_SOCK");
     qInfo() << "Running as user:" << qgetenv("USER");
 
+    // Render at the compositor's fractional scale rather than rounding it;
+    // Qt's Wayland plugin then sizes buffers to the physical pixels
+    QGuiApplication::setHighDpiScaleFactorRoundingPolicy(Qt::HighDpiScaleFactorRoundingPolicy::PassThrough);
     QGuiApplication app(argc, argv);
+    if (splash) {
+        splash->startDispatch();
+    }
+    MemoryMonitor memoryMonitor(&app);
+    memoryMonitor.reportPhase(QStringLiteral("startup"));
     QQuickStyle::setStyle(QStringLiteral("org.mauikit.style"));
     app.setApplicationName("qmlgreet");
     app.setApplicationVersion("1.0");
@@ -95,7 +173,7 @@ int main(int argc, char *argv[])
     parser.addHelpOption();
     parser.addVersionOption();
 
-    QCommandLineOption configOption(QStringList() << "c" << "config", "Path to config", "config", "/etc/qmlgreet/qmlgreet.conf");
+    QCommandLineOption configOption(QStringList() << "c" << "config", "Path to config", "config", defaultConfigPath);
     parser.addOption(configOption);
     parser.process(app);
 
@@ -106,6 +184,7 @@ int main(int argc, char *argv[])
     qmlRegisterType<SystemPower>("QmlGreet", 1, 0, "SystemPower");
     qmlRegisterType<LayerShell>("QmlGreet", 1, 0, "LayerShell");
     qmlRegisterType<SystemBattery>("QmlGreet", 1, 0, "SystemBattery");
+    qmlRegisterType<RoundImage>("QmlGreet", 1, 0, "RoundImage");
 
     // Default Configuration
     QString configPath = parser.value(configOption);
@@ -113,12 +192,33 @@ int main(int argc, char *argv[])
     QString defaultSession = "";
     QString avatarImagePath = "";
     bool showAvatars = true;
+    bool speculativeSession = false;
     bool debugBattery = false;
     bool blurEnabled = true;
     bool overlayEnabled = true;
     double overlayOpacity = 0.76;
     QString iconMode = QStringLiteral("system");
+    QString renderProfileMode = QStringLiteral("auto");
+    QString iconCacheFile = QStringLiteral("/var/cache/qmlgreet/icons.cache");
     bool lowercaseDate = false;
+    int stallThresholdMs = 0;
+    bool latencyHistograms = false;
+    bool damageStats = false;
+    QString sharedAssetDir = QStringLiteral("/run/qmlgreet");
+    int sharedAssetLimitMiB = 128;
+    QStringList slideshowSource;
+    int slideshowInterval = 300;
+    int idleTimeout = 60;
+    int screenOffTimeout = 600;
+    QString userSource = QStringLiteral("auto");
+    bool fastExit = true;
+    bool metricsEnabled = false;
+    QString metricsDirectory = QStringLiteral("/run/qmlgreet/metrics");
+    QString metricsSocket;
+    int metricsInterval = 30;
+    QString backgroundPriority = QStringLiteral("low");
+    QString maintenancePriority = QStringLiteral("idle");
+    AvatarProbeOptions avatarProbeOptions;
     // Load Configuration
     if (QFile::exists(configPath)) {
         QSettings config(configPath, QSettings::IniFormat);
@@ -131,10 +231,19 @@ int main(int argc, char *argv[])
         overlayOpacity = qBound(0.0, config.value("OverlayOpacity", overlayOpacity).toDouble(), 1.0);
         iconMode = config.value("IconMode", iconMode).toString().trimmed().toLower() == QStringLiteral("nerd")
             ? QStringLiteral("nerd") : QStringLiteral("system");
+        renderProfileMode = config.value("RenderProfile", renderProfileMode).toString();
+        iconCacheFile = config.value("IconCacheFile", iconCacheFile).toString();
+        // A directory, or a comma-separated list of images
+        slideshowSource = config.value("Slideshow").toStringList();
+        slideshowSource.removeAll(QString());
+        slideshowInterval = config.value("SlideshowInterval", slideshowInterval).toInt();
         config.endGroup();
 
         config.beginGroup("Debug");
         debugBattery = config.value("debugBattery", debugBattery).toBool();
+        stallThresholdMs = qMax(0, config.value("StallThresholdMs", stallThresholdMs).toInt());
+        latencyHistograms = config.value("LatencyHistograms", latencyHistograms).toBool();
+        damageStats = config.value("DamageStats", damageStats).toBool();
         config.endGroup();
 
         config.beginGroup("Clock");
@@ -143,19 +252,106 @@ int main(int argc, char *argv[])
 
         config.beginGroup("Behavior");
         showAvatars = config.value("ShowAvatars", showAvatars).toBool();
+        speculativeSession = config.value("SpeculativeSession", speculativeSession).toBool();
+        avatarProbeOptions.probeRemoteHomes = config.value("ProbeRemoteHomes", avatarProbeOptions.probeRemoteHomes).toBool();
+        avatarProbeOptions.timeoutMs = qMax(0, config.value("AvatarProbeTimeout", avatarProbeOptions.timeoutMs).toInt());
+        avatarProbeOptions.concurrency = qBound(1, config.value("AvatarProbeConcurrency", avatarProbeOptions.concurrency).toInt(), 16);
+        sharedAssetDir = config.value("SharedAssetCache", sharedAssetDir).toString().trimmed();
+        sharedAssetLimitMiB = qMax(1, config.value("SharedAssetCacheLimit", sharedAssetLimitMiB).toInt());
+        idleTimeout = qMax(0, config.value("IdleTimeout", idleTimeout).toInt());
+        screenOffTimeout = qMax(0, config.value("ScreenOffTimeout", screenOffTimeout).toInt());
+        userSource = config.value("UserSource", userSource).toString();
+        fastExit = config.value("FastExit", fastExit).toBool();
+        backgroundPriority = config.value("BackgroundPriority", backgroundPriority).toString();
+        maintenancePriority = config.value("MaintenancePriority", maintenancePriority).toString();
         config.endGroup();
 
+        config.beginGroup("Metrics");
+        metricsEnabled = config.value("Enabled", metricsEnabled).toBool();
+        metricsDirectory = config.value("Directory", metricsDirectory).toString().trimmed();
+        metricsSocket = config.value("Socket", metricsSocket).toString().trimmed();
+        metricsInterval = qMax(1, config.value("Interval", metricsInterval).toInt());
+        config.endGroup();
 
         // Read DefaultSession from root level (QSettings doesn't recognize [General] group)
         defaultSession = config.value("DefaultSession", "").toString();
     }
 
+    if (latencyHistograms) {
+        Instrumentation::setEnabled(true);
+        Instrumentation::installSignalDump(&app);
+        qInfo() << "Latency histograms enabled; send SIGUSR1 to dump them";
+    }
+
+    // Before any backend starts a worker
+    ThreadPriority::configure(backgroundPriority, maintenancePriority);
+
+    // The exported latencies come from the same histograms
+    std::unique_ptr<MetricsExporter> metrics;
+    if (metricsEnabled && !metricsDirectory.isEmpty()) {
+        Instrumentation::setEnabled(true);
+        metrics = std::make_unique<MetricsExporter>(metricsDirectory, metricsSocket, metricsInterval * 1000, processStartNs);
+    }
+
+    FastExit::setEnabled(fastExit);
+
+    std::unique_ptr<StallWatchdog> stallWatchdog;
+    if (stallThresholdMs > 0) {
+        stallWatchdog = std::make_unique<StallWatchdog>(stallThresholdMs);
+    }
+
+    // Backends register their expensive initialisation with the scheduler
+    StartupScheduler startupScheduler(&app);
+
     // Set background image
-    UserModel userModel(avatarImagePath, &app);
+    UserModel userModel(avatarImagePath, avatarProbeOptions, userSource, &app);
+    RenderProfile renderProfile(renderProfileMode, &app);
+
+    // Fall back to the greeter user's cache when the system cache is not writable
+    if (!QFileInfo(QFileInfo(iconCacheFile).absolutePath()).isWritable()) {
+        iconCacheFile = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/icons.cache");
+    }
+    IconCache iconCache(iconCacheFile);
+    // Read and closed again before the readahead manifest is recorded
+    Readahead::note(configPath);
+    Readahead::note(iconCacheFile);
+    Readahead::note(splashCacheFile);
+    SharedAssetCache sharedAssets(SharedAssetCache::defaultDirectory(sharedAssetDir), qint64(sharedAssetLimitMiB) * 1024 * 1024);
+    IdleMonitor idleMonitor(idleTimeout * 1000, &app);
+    OutputPower outputPower(screenOffTimeout * 1000, &idleMonitor, &app);
+    // Nothing should poll while the outputs are off
+    QObject::connect(&outputPower, &OutputPower::offChanged, &app, [&outputPower, &stallWatchdog, &metrics]() {
+        if (outputPower.off()) {
+            if (stallWatchdog) stallWatchdog->pause();
+            if (metrics) metrics->pause();
+        } else {
+            if (stallWatchdog) stallWatchdog->resume();
+            if (metrics) metrics->resume();
+        }
+    });
+    WallpaperSlideshow slideshow(slideshowSource, slideshowInterval, &sharedAssets, &app);
 
     QQmlApplicationEngine engine;
+    auto *avatarProvider = new AvatarImageProvider(&sharedAssets);
+    engine.addImageProvider(QStringLiteral("avatar"), avatarProvider);
+    RoundImage::setImageProvider(avatarProvider);
+    memoryMonitor.setEngine(&engine);
+    memoryMonitor.addCacheProbe(QStringLiteral("avatar-provider"), [avatarProvider]() {
+        return avatarProvider->cacheBytes();
+    });
+    engine.addImageProvider(QStringLiteral("wallpaper"), new WallpaperImageProvider(&sharedAssets));
+    memoryMonitor.addCacheProbe(QStringLiteral("shared-assets-mapped"), []() {
+        return SharedAssetCache::mappedBytes();
+    });
+    engine.addImageProvider(QStringLiteral("slideshow"), new SlideshowImageProvider(&slideshow));
+    auto *themeIconProvider = new ThemeIconProvider(&iconCache);
+    engine.addImageProvider(QStringLiteral("themeicon"), themeIconProvider);
+    memoryMonitor.addCacheProbe(QStringLiteral("theme-icons"), [themeIconProvider]() {
+        return themeIconProvider->cacheBytes();
+    });
     engine.rootContext()->setContextProperty("ConfigBackgroundImage", backgroundImagePath);
     engine.rootContext()->setContextProperty("ConfigShowAvatars", showAvatars);
+    engine.rootContext()->setContextProperty("ConfigSpeculativeSession", speculativeSession);
     engine.rootContext()->setContextProperty("ConfigDebugBattery", debugBattery);
     engine.rootContext()->setContextProperty("ConfigBlurEnabled", blurEnabled);
     engine.rootContext()->setContextProperty("ConfigOverlayEnabled", overlayEnabled);
@@ -164,6 +360,11 @@ int main(int argc, char *argv[])
     engine.rootContext()->setContextProperty("ConfigLowercaseDate", lowercaseDate);
     engine.rootContext()->setContextProperty("userModel", &userModel);
     engine.rootContext()->setContextProperty("ConfigDefaultSession", defaultSession);
+    engine.rootContext()->setContextProperty("renderProfile", &renderProfile);
+    engine.rootContext()->setContextProperty("memoryMonitor", &memoryMonitor);
+    engine.rootContext()->setContextProperty("idleMonitor", &idleMonitor);
+    engine.rootContext()->setContextProperty("outputPower", &outputPower);
+    engine.rootContext()->setContextProperty("slideshow", &slideshow);
 
     const QUrl url(QStringLiteral("qrc:/resources/qml/main.qml"));
     QObject::connect(&engine, &QQmlApplicationEngine::objectCreated,
@@ -173,8 +374,104 @@ int main(int argc, char *argv[])
 
     engine.load(url);
 
+    std::unique_ptr<BenchDriver> benchDriver;
+#ifdef QMLGREET_DAMAGE_STATS
+    std::unique_ptr<DamageStats> damageCounter;
+#endif
+    if (!engine.rootObjects().isEmpty()) {
+        QQuickWindow *window = qobject_cast<QQuickWindow *>(engine.rootObjects().first());
+        renderProfile.attachWindow(window);
+        memoryMonitor.attachWindow(window);
+        startupScheduler.attachWindow(window);
+        FastExit::setWindow(window);
+        if (metrics) {
+            metrics->attachWindow(window);
+        }
+        if (damageStats) {
+#ifdef QMLGREET_DAMAGE_STATS
+            damageCounter = std::make_unique<DamageStats>();
+            damageCounter->attachWindow(window);
+#else
+            qWarning() << "DamageStats: Not built in, rebuild with -Ddamage_stats=true";
+#endif
+        }
+        if (BenchDriver::isRequested()) {
+            benchDriver = std::make_unique<BenchDriver>(processStartNs, &engine, window, &startupScheduler);
+        }
+        if (splash) {
+            QObject::connect(&startupScheduler, &StartupScheduler::firstFrameSwapped, &app, [&splash]() {
+                // Swapped is not yet shown; give the compositor a frame or
+                // two to put the window up before the splash underneath goes
+                QTimer::singleShot(100, qApp, [&splash]() { splash.reset(); });
+            });
+        }
+        if (!splashCacheFile.isEmpty() && window) {
+            // Everything that changes the background: the config and the wallpaper
+            QByteArray splashSource;
+            QFile configFile(configPath);
+            if (configFile.open(QIODevice::ReadOnly)) {
+                splashSource = QCryptographicHash::hash(configFile.readAll(), QCryptographicHash::Sha256);
+            }
+            splashSource += QFile::encodeName(backgroundImagePath)
+                + QByteArray::number(QFileInfo(backgroundImagePath).lastModified().toMSecsSinceEpoch());
+            StartupScheduler::schedule(StartupScheduler::Idle, QStringLiteral("splash-cache"), window,
+                                       [window, splashCacheFile, splashSource]() {
+                SplashSurface::updateCache(window->findChild<QQuickItem *>(QStringLiteral("background")),
+                                           splashCacheFile, splashSource);
+            });
+        }
+    } else {
+        startupScheduler.attachWindow(nullptr);
+        splash.reset();
+    }
+    StartupScheduler::schedule(StartupScheduler::Idle, QStringLiteral("shared-assets-prune"), &app, [&sharedAssets]() {
+        (void)ThreadPriority::run(ThreadPriority::Maintenance, [&sharedAssets]() { sharedAssets.prune(); });
+    });
+    // Once the first frame and its deferred work are done, everything the
+    // start needed is mapped or was noted
+    StartupScheduler::schedule(StartupScheduler::Idle, QStringLiteral("readahead-record"), &app, []() {
+        Readahead::record();
+    });
+    // The icon theme is known once MauiKit is loaded. Icons the first frame
+    // needs are resolved on demand; this persists the rest.
+    StartupScheduler::schedule(StartupScheduler::Idle, QStringLiteral("icon-cache"), &app, [&iconCache]() {
+        iconCache.warm(SystemBattery::iconNames(), 16);
+        iconCache.warm({ QStringLiteral("system-suspend"), QStringLiteral("system-suspend-hibernate"),
+                         QStringLiteral("system-reboot"), QStringLiteral("system-shutdown") }, 40);
+    });
+
+    memoryMonitor.reportPhase(QStringLiteral("engine-loaded"));
+
+    // Exit-time reports; run by FastExit when the session starts, otherwise below
+    FastExit::addHook([&]() {
+        if (stallWatchdog) {
+            stallWatchdog->logSummary();
+        }
+        Instrumentation::dump();
+#ifdef QMLGREET_DAMAGE_STATS
+        if (damageCounter) {
+            damageCounter->logSummary();
+        }
+#endif
+        outputPower.logSummary();
+        // Icons first resolved after the idle warm-up
+        iconCache.save();
+        if (metrics) {
+            metrics->write();
+        }
+        if (benchDriver) {
+            benchDriver->finish();
+        }
+    });
+
     int result = app.exec();
 
+    FastExit::runHooks();
+    // Its socket notifier must go before the application
+    splash.reset();
+    // Maintenance tasks use objects on this stack
+    ThreadPriority::pool(ThreadPriority::Maintenance)->waitForDone();
+
     // Close syslog connection
     closelog();
 
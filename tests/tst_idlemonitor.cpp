@@ -0,0 +1,97 @@
+// Input while the outputs are off must wake them without reaching the UI.
+// Run with QT_QPA_PLATFORM=offscreen.
+
+#include "backend/IdleMonitor.h"
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QSignalSpy>
+#include <QTest>
+
+class KeyRecorder : public QQuickItem
+{
+public:
+    explicit KeyRecorder(QQuickItem *parent)
+        : QQuickItem(parent)
+    {
+        setFlag(ItemIsFocusScope);
+    }
+
+    int presses = 0;
+    int releases = 0;
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override
+    {
+        ++presses;
+        event->accept();
+    }
+    void keyReleaseEvent(QKeyEvent *event) override
+    {
+        ++releases;
+        event->accept();
+    }
+};
+
+class TestIdleMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init()
+    {
+        m_window = new QQuickWindow;
+        m_window->resize(200, 200);
+        m_item = new KeyRecorder(m_window->contentItem());
+        m_window->show();
+        QVERIFY(QTest::qWaitForWindowExposed(m_window));
+        m_window->requestActivate();
+        m_item->forceActiveFocus();
+        QVERIFY(m_item->hasActiveFocus());
+    }
+
+    void cleanup()
+    {
+        delete m_window;
+    }
+
+    void keyPressPassesThroughWhileOn()
+    {
+        IdleMonitor monitor(0);
+        QSignalSpy activity(&monitor, &IdleMonitor::activity);
+
+        QTest::keyClick(m_window, Qt::Key_Return);
+
+        QCOMPARE(m_item->presses, 1);
+        QCOMPARE(m_item->releases, 1);
+        QVERIFY(activity.count() > 0);
+    }
+
+    void keyPressWhileBlankedDoesNotReachFocusedItem()
+    {
+        IdleMonitor monitor(0);
+        monitor.setConsumeInput(true);
+        // What OutputPower does when the outputs come back on
+        connect(&monitor, &IdleMonitor::activity, &monitor, [&monitor]() { monitor.setConsumeInput(false); });
+        QSignalSpy activity(&monitor, &IdleMonitor::activity);
+
+        QTest::keyPress(m_window, Qt::Key_Return);
+        QVERIFY(activity.count() > 0);
+        QCOMPARE(m_item->presses, 0);
+
+        // The release of the waking key is swallowed too
+        QTest::keyRelease(m_window, Qt::Key_Return);
+        QCOMPARE(m_item->releases, 0);
+
+        // Once awake, input is delivered again
+        QTest::keyClick(m_window, Qt::Key_Return);
+        QCOMPARE(m_item->presses, 1);
+        QCOMPARE(m_item->releases, 1);
+    }
+
+private:
+    QQuickWindow *m_window = nullptr;
+    KeyRecorder *m_item = nullptr;
+};
+
+QTEST_MAIN(TestIdleMonitor)
+#include "tst_idlemonitor.moc"
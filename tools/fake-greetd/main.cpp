@@ -0,0 +1,284 @@
+// A local stand-in for greetd: speaks the same length-prefixed JSON over a
+// Unix socket, with scriptable prompts and reply delays, and reports when
+// each request arrived so login-flow benchmarks can attribute time.
+//
+// Script (JSON), every key optional:
+// {
+//   "create_session_delay_ms": 30,
+//   "prompts": [ { "type": "secret", "message": "Password:", "delay_ms": 80, "expect": "bench" } ],
+//   "start_session_delay_ms": 10,
+//   "cancel_session_delay_ms": 0
+// }
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QTimer>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+struct Prompt {
+    QString type = QStringLiteral("secret");
+    QString message = QStringLiteral("Password:");
+    int delayMs = 0;
+    QString expect;  // Empty accepts any answer
+};
+
+struct Script {
+    int createSessionDelayMs = 0;
+    int startSessionDelayMs = 0;
+    int cancelSessionDelayMs = 0;
+    QList<Prompt> prompts { Prompt() };
+};
+
+double monotonicMs()
+{
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool loadScript(const QString &path, Script *script)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "fake-greetd: cannot open script %s\n", qPrintable(path));
+        return false;
+    }
+
+    QJsonParseError error;
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll(), &error).object();
+    if (error.error != QJsonParseError::NoError) {
+        fprintf(stderr, "fake-greetd: %s: %s\n", qPrintable(path), qPrintable(error.errorString()));
+        return false;
+    }
+
+    script->createSessionDelayMs = root.value("create_session_delay_ms").toInt(script->createSessionDelayMs);
+    script->startSessionDelayMs = root.value("start_session_delay_ms").toInt(script->startSessionDelayMs);
+    script->cancelSessionDelayMs = root.value("cancel_session_delay_ms").toInt(script->cancelSessionDelayMs);
+
+    if (root.contains("prompts")) {
+        script->prompts.clear();
+        for (const QJsonValue &value : root.value("prompts").toArray()) {
+            const QJsonObject object = value.toObject();
+            Prompt prompt;
+            prompt.type = object.value("type").toString(prompt.type);
+            prompt.message = object.value("message").toString(prompt.message);
+            prompt.delayMs = object.value("delay_ms").toInt(0);
+            prompt.expect = object.value("expect").toString();
+            script->prompts << prompt;
+        }
+    }
+    return true;
+}
+
+class Reporter
+{
+public:
+    explicit Reporter(const QString &path)
+        : m_file(path)
+    {
+        if (!path.isEmpty() && !m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            fprintf(stderr, "fake-greetd: cannot write report %s\n", qPrintable(path));
+        }
+    }
+
+    void event(const QString &name)
+    {
+        const QString line = QStringLiteral("%1 %2").arg(name).arg(monotonicMs(), 0, 'f', 3);
+        fprintf(stderr, "fake-greetd: %s\n", qPrintable(line));
+        if (m_file.isOpen()) {
+            QTextStream(&m_file) << line << '\n';
+            m_file.flush();
+        }
+    }
+
+private:
+    QFile m_file;
+};
+
+class Client : public QObject
+{
+public:
+    Client(QLocalSocket *socket, const Script &script, Reporter *reporter, bool quitOnStart)
+        : QObject(socket)
+        , m_socket(socket)
+        , m_script(script)
+        , m_reporter(reporter)
+        , m_quitOnStart(quitOnStart)
+    {
+        m_reporter->event(QStringLiteral("connected"));
+        connect(socket, &QLocalSocket::readyRead, this, [this]() { onReadyRead(); });
+        connect(socket, &QLocalSocket::disconnected, this, [this]() {
+            m_reporter->event(QStringLiteral("disconnected"));
+            if (m_quitOnStart && m_sessionStarted) {
+                QCoreApplication::quit();
+            }
+            m_socket->deleteLater();
+        });
+    }
+
+private:
+    void onReadyRead()
+    {
+        m_buffer.append(m_socket->readAll());
+
+        while (m_buffer.size() >= 4) {
+            quint32 length = 0;
+            QDataStream stream(m_buffer.left(4));
+            stream.setByteOrder(QDataStream::ByteOrder(QSysInfo::ByteOrder));
+            stream >> length;
+            if (quint32(m_buffer.size()) < 4 + length) {
+                return;
+            }
+
+            const QJsonObject request = QJsonDocument::fromJson(m_buffer.mid(4, int(length))).object();
+            m_buffer.remove(0, int(4 + length));
+            handle(request);
+        }
+    }
+
+    void handle(const QJsonObject &request)
+    {
+        const QString type = request.value("type").toString();
+        m_reporter->event(type);
+
+        if (type == "create_session") {
+            m_promptIndex = 0;
+            replyWithNextStep(m_script.createSessionDelayMs);
+        } else if (type == "post_auth_message_response") {
+            const Prompt &prompt = m_script.prompts.value(m_promptIndex);
+            if (!prompt.expect.isEmpty() && request.value("response").toString() != prompt.expect) {
+                reply(error(QStringLiteral("auth_error"), QStringLiteral("Authentication failed")), prompt.delayMs);
+                return;
+            }
+            ++m_promptIndex;
+            replyWithNextStep(m_script.prompts.value(m_promptIndex).delayMs);
+        } else if (type == "start_session") {
+            m_sessionStarted = true;
+            reply(success(), m_script.startSessionDelayMs);
+        } else if (type == "cancel_session") {
+            m_promptIndex = 0;
+            reply(success(), m_script.cancelSessionDelayMs);
+        } else {
+            reply(error(QStringLiteral("error"), QStringLiteral("Unknown request ") + type), 0);
+        }
+    }
+
+    void replyWithNextStep(int delayMs)
+    {
+        if (m_promptIndex >= m_script.prompts.size()) {
+            reply(success(), delayMs);
+            return;
+        }
+
+        const Prompt &prompt = m_script.prompts.at(m_promptIndex);
+        QJsonObject message;
+        message["type"] = "auth_message";
+        message["auth_message_type"] = prompt.type;
+        message["auth_message"] = prompt.message;
+        reply(message, delayMs);
+    }
+
+    // Replies keep request order even when an earlier one is delayed longer
+    void reply(const QJsonObject &json, int delayMs)
+    {
+        const double due = qMax(monotonicMs(), m_lastReplyDue) + qMax(0, delayMs);
+        m_lastReplyDue = due;
+
+        QTimer::singleShot(int(qMax(0.0, due - monotonicMs())), this, [this, json]() {
+            const QByteArray payload = QJsonDocument(json).toJson(QJsonDocument::Compact);
+            QByteArray packet;
+            QDataStream stream(&packet, QIODevice::WriteOnly);
+            stream.setByteOrder(QDataStream::ByteOrder(QSysInfo::ByteOrder));
+            stream << quint32(payload.size());
+            packet.append(payload);
+            m_socket->write(packet);
+            m_socket->flush();
+        });
+    }
+
+    static QJsonObject success()
+    {
+        QJsonObject json;
+        json["type"] = "success";
+        return json;
+    }
+
+    static QJsonObject error(const QString &errorType, const QString &description)
+    {
+        QJsonObject json;
+        json["type"] = "error";
+        json["error_type"] = errorType;
+        json["description"] = description;
+        return json;
+    }
+
+    QLocalSocket *m_socket;
+    const Script m_script;
+    Reporter *m_reporter;
+    const bool m_quitOnStart;
+    QByteArray m_buffer;
+    int m_promptIndex = 0;
+    bool m_sessionStarted = false;
+    double m_lastReplyDue = 0;
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("fake-greetd");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local stand-in for greetd, for testing and benchmarking qmlgreet");
+    parser.addHelpOption();
+    QCommandLineOption socketOption("socket", "Socket path (defaults to $GREETD_SOCK)", "path");
+    QCommandLineOption scriptOption("script", "JSON file with prompts and delays", "file");
+    QCommandLineOption reportOption("report", "Write '<request> <monotonic ms>' lines to this file", "file");
+    QCommandLineOption onceOption("once", "Exit after a client that started a session disconnects");
+    parser.addOptions({ socketOption, scriptOption, reportOption, onceOption });
+    parser.process(app);
+
+    const QString socketPath = parser.isSet(socketOption)
+        ? parser.value(socketOption) : qEnvironmentVariable("GREETD_SOCK");
+    if (socketPath.isEmpty()) {
+        fprintf(stderr, "fake-greetd: no socket path; pass --socket or set GREETD_SOCK\n");
+        return 1;
+    }
+
+    Script script;
+    if (parser.isSet(scriptOption) && !loadScript(parser.value(scriptOption), &script)) {
+        return 1;
+    }
+
+    Reporter reporter(parser.value(reportOption));
+    const bool once = parser.isSet(onceOption);
+
+    QLocalServer::removeServer(socketPath);
+    QLocalServer server;
+    if (!server.listen(socketPath)) {
+        fprintf(stderr, "fake-greetd: cannot listen on %s: %s\n",
+                qPrintable(socketPath), qPrintable(server.errorString()));
+        return 1;
+    }
+
+    QObject::connect(&server, &QLocalServer::newConnection, &server, [&]() {
+        while (QLocalSocket *socket = server.nextPendingConnection()) {
+            new Client(socket, script, &reporter, once);
+        }
+    });
+
+    reporter.event(QStringLiteral("listening"));
+    return app.exec();
+}
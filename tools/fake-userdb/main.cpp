@@ -0,0 +1,292 @@
+// A local stand-in for systemd-userdb and AccountsService, so the greeter's
+// user sources can be exercised without either service.
+//
+// Serves user records from a JSON file over the io.systemd.UserDatabase
+// Varlink interface and, with --accounts, as org.freedesktop.Accounts on the
+// session bus (run the greeter with QMLGREET_ACCOUNTS_BUS=session).
+//
+// Users file (JSON array of userdb records, every key but userName optional):
+// [
+//   { "userName": "alice", "uid": 1000, "realName": "Alice", "homeDirectory": "/home/alice",
+//     "disposition": "regular", "blobDirectory": "/var/cache/systemd/home/alice" },
+//   { "userName": "daemon", "uid": 1, "disposition": "system" }
+// ]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusError>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusVirtualObject>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTimer>
+#include <cstdio>
+#include <limits>
+
+namespace {
+
+bool loadUsers(const QString &path, QJsonArray *users)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "fake-userdb: cannot open users file %s\n", qPrintable(path));
+        return false;
+    }
+
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !document.isArray()) {
+        fprintf(stderr, "fake-userdb: %s: %s\n", qPrintable(path),
+                error.error != QJsonParseError::NoError ? qPrintable(error.errorString()) : "expected an array");
+        return false;
+    }
+
+    *users = document.array();
+    return true;
+}
+
+bool isRegular(const QJsonObject &record)
+{
+    const QString disposition = record.value("disposition").toString();
+    if (!disposition.isEmpty()) {
+        return disposition == QStringLiteral("regular");
+    }
+    const qint64 uid = record.value("uid").toInteger(-1);
+    return uid >= 1000 && uid < 60000;
+}
+
+// Varlink: NUL-terminated JSON calls and replies on a Unix socket
+class VarlinkClient : public QObject
+{
+public:
+    VarlinkClient(QLocalSocket *socket, const QJsonArray &users, int delayMs)
+        : QObject(socket)
+        , m_socket(socket)
+        , m_users(users)
+        , m_delayMs(delayMs)
+    {
+        connect(socket, &QLocalSocket::readyRead, this, [this]() { onReadyRead(); });
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    }
+
+private:
+    void onReadyRead()
+    {
+        m_buffer += m_socket->readAll();
+
+        int end;
+        while ((end = m_buffer.indexOf('\0')) >= 0) {
+            const QJsonObject call = QJsonDocument::fromJson(m_buffer.left(end)).object();
+            m_buffer.remove(0, end + 1);
+
+            // Replies are delayed to model a slow NSS backend behind the multiplexer
+            QTimer::singleShot(m_delayMs, this, [this, call]() { handle(call); });
+        }
+    }
+
+    void handle(const QJsonObject &call)
+    {
+        const QString method = call.value("method").toString();
+        if (method != QStringLiteral("io.systemd.UserDatabase.GetUserRecord")) {
+            send({ { "error", "org.varlink.service.MethodNotFound" },
+                   { "parameters", QJsonObject { { "method", method } } } });
+            return;
+        }
+
+        const QJsonObject parameters = call.value("parameters").toObject();
+        const QString userName = parameters.value("userName").toString();
+        const bool more = call.value("more").toBool();
+
+        // The filters userdb gained in systemd v257
+        const QJsonArray dispositionMask = parameters.value("dispositionMask").toArray();
+        const qint64 uidMin = parameters.value("uidMin").toInteger(0);
+        const qint64 uidMax = parameters.value("uidMax").toInteger(std::numeric_limits<qint64>::max());
+
+        QJsonArray matches;
+        for (const QJsonValue &value : m_users) {
+            const QJsonObject record = value.toObject();
+            if (!userName.isEmpty() && record.value("userName").toString() != userName) {
+                continue;
+            }
+            const QString disposition = record.value("disposition")
+                .toString(isRegular(record) ? QStringLiteral("regular") : QStringLiteral("system"));
+            if (!dispositionMask.isEmpty() && !dispositionMask.contains(disposition)) {
+                continue;
+            }
+            const qint64 uid = record.value("uid").toInteger(-1);
+            if (record.contains("uid") && (uid < uidMin || uid > uidMax)) {
+                continue;
+            }
+            matches << record;
+        }
+
+        if (matches.isEmpty()) {
+            send({ { "error", "io.systemd.UserDatabase.NoRecordFound" } });
+            return;
+        }
+        if (!more && matches.size() > 1) {
+            // userdb refuses to enumerate without "more"
+            send({ { "error", "io.systemd.UserDatabase.ConflictingRecordFound" } });
+            return;
+        }
+
+        for (int i = 0; i < matches.size(); ++i) {
+            QJsonObject reply { { "parameters", QJsonObject { { "record", matches.at(i) }, { "incomplete", false } } } };
+            if (i + 1 < matches.size()) {
+                reply.insert("continues", true);
+            }
+            send(reply);
+        }
+    }
+
+    void send(const QJsonObject &reply)
+    {
+        m_socket->write(QJsonDocument(reply).toJson(QJsonDocument::Compact) + '\0');
+    }
+
+    QLocalSocket *m_socket;
+    const QJsonArray m_users;
+    const int m_delayMs;
+    QByteArray m_buffer;
+};
+
+// org.freedesktop.Accounts with one org.freedesktop.Accounts.User object per record
+class AccountsService : public QDBusVirtualObject
+{
+public:
+    explicit AccountsService(const QJsonArray &users)
+        : m_users(users)
+    {
+    }
+
+    QString introspect(const QString &path) const override
+    {
+        Q_UNUSED(path);
+        return QString();
+    }
+
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override
+    {
+        if (message.path() == QStringLiteral("/org/freedesktop/Accounts")
+            && message.member() == QStringLiteral("ListCachedUsers")) {
+            // AccountsService only lists users that are not system accounts
+            QList<QDBusObjectPath> paths;
+            for (const QJsonValue &value : m_users) {
+                const QJsonObject record = value.toObject();
+                if (isRegular(record)) {
+                    paths << QDBusObjectPath(userPath(record));
+                }
+            }
+            connection.send(message.createReply(QVariant::fromValue(paths)));
+            return true;
+        }
+
+        if (message.interface() == QStringLiteral("org.freedesktop.DBus.Properties")
+            && message.member() == QStringLiteral("GetAll")) {
+            for (const QJsonValue &value : m_users) {
+                const QJsonObject record = value.toObject();
+                if (userPath(record) == message.path()) {
+                    connection.send(message.createReply(properties(record)));
+                    return true;
+                }
+            }
+        }
+
+        connection.send(message.createErrorReply(QDBusError::UnknownObject, message.path()));
+        return true;
+    }
+
+private:
+    static QString userPath(const QJsonObject &record)
+    {
+        return QStringLiteral("/org/freedesktop/Accounts/User%1").arg(record.value("uid").toInteger());
+    }
+
+    static QVariantMap properties(const QJsonObject &record)
+    {
+        const QString blobDirectory = record.value("blobDirectory").toString();
+        return {
+            { "UserName", record.value("userName").toString() },
+            { "RealName", record.value("realName").toString() },
+            { "HomeDirectory", record.value("homeDirectory").toString() },
+            { "IconFile", blobDirectory.isEmpty() ? QString() : blobDirectory + QStringLiteral("/avatar") },
+            { "Uid", QVariant::fromValue(quint64(record.value("uid").toInteger())) },
+            { "SystemAccount", !isRegular(record) },
+            { "Locked", false },
+        };
+    }
+
+    const QJsonArray m_users;
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("fake-userdb"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Stand-in for systemd-userdb and AccountsService"));
+    parser.addHelpOption();
+    const QCommandLineOption usersOption(QStringLiteral("users"), QStringLiteral("JSON array of user records"),
+                                         QStringLiteral("file"));
+    const QCommandLineOption socketOption(QStringLiteral("socket"), QStringLiteral("Varlink socket to listen on"),
+                                          QStringLiteral("path"));
+    const QCommandLineOption accountsOption(QStringLiteral("accounts"),
+                                            QStringLiteral("Also serve org.freedesktop.Accounts on the session bus"));
+    const QCommandLineOption delayOption(QStringLiteral("delay-ms"), QStringLiteral("Delay before each Varlink reply"),
+                                         QStringLiteral("ms"), QStringLiteral("0"));
+    parser.addOptions({ usersOption, socketOption, accountsOption, delayOption });
+    parser.process(app);
+
+    QJsonArray users;
+    if (!parser.isSet(usersOption) || !loadUsers(parser.value(usersOption), &users)) {
+        parser.showHelp(1);
+    }
+
+    QLocalServer server;
+    if (parser.isSet(socketOption)) {
+        const QString path = parser.value(socketOption);
+        QLocalServer::removeServer(path);
+        if (!server.listen(path)) {
+            fprintf(stderr, "fake-userdb: cannot listen on %s: %s\n", qPrintable(path),
+                    qPrintable(server.errorString()));
+            return 1;
+        }
+
+        const int delayMs = parser.value(delayOption).toInt();
+        QObject::connect(&server, &QLocalServer::newConnection, &server, [&server, &users, delayMs]() {
+            while (QLocalSocket *socket = server.nextPendingConnection()) {
+                new VarlinkClient(socket, users, delayMs);
+            }
+        });
+        fprintf(stderr, "fake-userdb: serving %lld record(s) on %s\n", qlonglong(users.size()), qPrintable(path));
+    }
+
+    AccountsService accounts(users);
+    if (parser.isSet(accountsOption)) {
+        QDBusConnection bus = QDBusConnection::sessionBus();
+        if (!bus.registerVirtualObject(QStringLiteral("/org/freedesktop/Accounts"), &accounts,
+                                       QDBusConnection::SubPath)
+            || !bus.registerService(QStringLiteral("org.freedesktop.Accounts"))) {
+            fprintf(stderr, "fake-userdb: cannot register org.freedesktop.Accounts: %s\n",
+                    qPrintable(bus.lastError().message()));
+            return 1;
+        }
+        fprintf(stderr, "fake-userdb: serving org.freedesktop.Accounts on the session bus\n");
+    }
+
+    if (!server.isListening() && !parser.isSet(accountsOption)) {
+        fprintf(stderr, "fake-userdb: nothing to serve, pass --socket and/or --accounts\n");
+        return 1;
+    }
+
+    return app.exec();
+}